@@ -54,6 +54,23 @@ esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t
  */
 esp_err_t led_strip_set_pixel_rgbw(led_strip_handle_t strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+/**
+ * @brief Set RGB for a run of consecutive pixels
+ *
+ * @note One call updates the whole run, e.g. the whole strip before a refresh. On RGBW strips the white component is set to 0.
+ *
+ * @param strip: LED strip
+ * @param start: index of the first pixel to set
+ * @param count: number of pixels to set
+ * @param rgb: colors as red, green, blue bytes per pixel (3 * count bytes)
+ *
+ * @return
+ *      - ESP_OK: Set RGB for the pixels successfully
+ *      - ESP_ERR_INVALID_ARG: Set RGB for the pixels failed because of invalid parameters or a range beyond the strip
+ *      - ESP_FAIL: Set RGB for the pixels failed because other error occurred
+ */
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *rgb);
+
 /**
  * @brief Set HSV for a specific pixel
  *
@@ -81,9 +98,46 @@ esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint
  *
  * @note:
  *      After updating the LED colors in the memory, a following invocation of this API is needed to flush colors to strip.
+ *      The RMT (ESP-IDF 5.x) and SPI backends only send the pixels up to the last one whose color changed since the previous refresh, and nothing if none did.
+ *      LEDs that lost power meanwhile keep their old colors in memory: call `led_strip_clear` before setting them again so the whole strip is sent.
  */
 esp_err_t led_strip_refresh(led_strip_handle_t strip);
 
+/**
+ * @brief Refresh memory colors to LEDs without waiting for the transfer
+ *
+ * @note The colors are copied to a second buffer and queued, so the pixels of the next frame can be set while this one shifts out.
+ * @note `done_cb` runs in ISR context once the frame is sent: keep it short and only use ISR-safe calls, e.g. `vTaskNotifyGiveFromISR`.
+ * @note Backends without asynchronous support (the RMT backend on ESP-IDF 4.x) refresh synchronously and call `done_cb` from the calling task.
+ * @note As with `led_strip_refresh` only the changed pixels are sent; if no color changed nothing is queued and `done_cb` is called from the calling task.
+ *
+ * @param strip: LED strip
+ * @param done_cb: callback invoked once the frame is sent, may be NULL
+ * @param user_ctx: user context passed to done_cb
+ *
+ * @return
+ *      - ESP_OK: Refresh queued successfully
+ *      - ESP_ERR_INVALID_STATE: Refresh failed because the previous asynchronous refresh is still in progress
+ *      - ESP_ERR_NO_MEM: Refresh failed because there is no memory for the transmit buffer
+ *      - ESP_FAIL: Refresh failed because some other error occurred
+ */
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip, led_strip_refresh_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief Wait for an asynchronous refresh to complete
+ *
+ * @note On the RMT backend the channel stays enabled after an asynchronous refresh (it cannot be disabled from the ISR); waiting disables it again and releases its power management lock.
+ *
+ * @param strip: LED strip
+ * @param timeout_ms: timeout value in milliseconds, -1 to wait forever
+ *
+ * @return
+ *      - ESP_OK: No refresh in progress any more
+ *      - ESP_ERR_TIMEOUT: The refresh is still in progress after timeout_ms
+ *      - ESP_FAIL: Wait failed because some other error occurred
+ */
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int32_t timeout_ms);
+
 /**
  * @brief Clear LED strip (turn off all LEDs)
  *
@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include "esp_err.h"
+#include "led_strip_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +52,23 @@ struct led_strip_t {
      */
     esp_err_t (*set_pixel_rgbw)(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white);
 
+    /**
+     * @brief Set RGB for a run of consecutive pixels
+     *
+     * @param strip: LED strip
+     * @param start: index of the first pixel to set
+     * @param count: number of pixels to set
+     * @param rgb: colors as red, green, blue bytes per pixel (3 * count bytes)
+     *
+     * @return
+     *      - ESP_OK: Set RGB for the pixels successfully
+     *      - ESP_ERR_INVALID_ARG: Set RGB for the pixels failed because the range exceeds the strip
+     *      - ESP_FAIL: Set RGB for the pixels failed because other error occurred
+     *
+     * @note: Optional, NULL for backends without a bulk path; the white component of RGBW strips is set to 0
+     */
+    esp_err_t (*set_pixels)(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *rgb);
+
     /**
      * @brief Refresh memory colors to LEDs
      *
@@ -66,6 +84,38 @@ struct led_strip_t {
      */
     esp_err_t (*refresh)(led_strip_t *strip);
 
+    /**
+     * @brief Queue a copy of the memory colors for the LEDs and return without waiting
+     *
+     * @param strip: LED strip
+     * @param done_cb: callback invoked from ISR context once the frame is sent, may be NULL
+     * @param user_ctx: user context passed to done_cb
+     *
+     * @return
+     *      - ESP_OK: Refresh queued successfully
+     *      - ESP_ERR_INVALID_STATE: Refresh failed because the previous asynchronous refresh is still in progress
+     *      - ESP_ERR_NO_MEM: Refresh failed because there is no memory for the transmit buffer
+     *      - ESP_FAIL: Refresh failed because some other error occurred
+     *
+     * @note: Optional, NULL for backends that only refresh synchronously
+     */
+    esp_err_t (*refresh_async)(led_strip_t *strip, led_strip_refresh_done_cb_t done_cb, void *user_ctx);
+
+    /**
+     * @brief Wait for an asynchronous refresh to complete
+     *
+     * @param strip: LED strip
+     * @param timeout_ms: timeout value in milliseconds, -1 to wait forever
+     *
+     * @return
+     *      - ESP_OK: No refresh in progress any more
+     *      - ESP_ERR_TIMEOUT: The refresh is still in progress after timeout_ms
+     *      - ESP_FAIL: Wait failed because some other error occurred
+     *
+     * @note: Optional, NULL for backends that only refresh synchronously
+     */
+    esp_err_t (*wait_refresh_done)(led_strip_t *strip, int32_t timeout_ms);
+
     /**
      * @brief Clear LED strip (turn off all LEDs)
      *
@@ -16,6 +16,20 @@ esp_err_t led_strip_set_pixel(led_strip_handle_t strip, uint32_t index, uint32_t
     return strip->set_pixel(strip, index, red, green, blue);
 }
 
+esp_err_t led_strip_set_pixels(led_strip_handle_t strip, uint32_t start, uint32_t count, const uint8_t *rgb)
+{
+    ESP_RETURN_ON_FALSE(strip && (rgb || count == 0), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->set_pixels) {
+        return strip->set_pixels(strip, start, count, rgb);
+    }
+    // backend without a bulk path, set the pixels one by one
+    for (uint32_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_ERROR(strip->set_pixel(strip, start + i, rgb[0], rgb[1], rgb[2]), TAG, "set pixel failed");
+        rgb += 3;
+    }
+    return ESP_OK;
+}
+
 esp_err_t led_strip_set_pixel_hsv(led_strip_handle_t strip, uint32_t index, uint16_t hue, uint8_t saturation, uint8_t value)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -81,6 +95,29 @@ esp_err_t led_strip_refresh(led_strip_handle_t strip)
     return strip->refresh(strip);
 }
 
+esp_err_t led_strip_refresh_async(led_strip_handle_t strip, led_strip_refresh_done_cb_t done_cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->refresh_async) {
+        return strip->refresh_async(strip, done_cb, user_ctx);
+    }
+    // backend without asynchronous support, refresh synchronously and report completion right away
+    ESP_RETURN_ON_ERROR(strip->refresh(strip), TAG, "refresh failed");
+    if (done_cb) {
+        done_cb(strip, user_ctx);
+    }
+    return ESP_OK;
+}
+
+esp_err_t led_strip_wait_refresh_done(led_strip_handle_t strip, int32_t timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    if (strip->wait_refresh_done) {
+        return strip->wait_refresh_done(strip, timeout_ms);
+    }
+    return ESP_OK;
+}
+
 esp_err_t led_strip_clear(led_strip_handle_t strip)
 {
     ESP_RETURN_ON_FALSE(strip, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
@@ -8,6 +8,7 @@
 #include <sys/cdefs.h>
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_attr.h"
 #include "driver/rmt_tx.h"
 #include "led_strip.h"
 #include "led_strip_interface.h"
@@ -30,21 +31,34 @@ typedef struct {
     rmt_encoder_handle_t strip_encoder;
     uint32_t strip_len;
     uint8_t bytes_per_pixel;
+    uint32_t dirty_len;                  // leading pixels changed since the last refresh, the prefix to send
+    bool enabled;                        // channel enabled, left so after an asynchronous refresh
+    volatile bool async_pending;         // asynchronous refresh not sent out yet, cleared in ISR
+    led_strip_refresh_done_cb_t done_cb; // callback of the asynchronous refresh
+    void *done_ctx;
+    uint8_t *tx_buf;                     // frame being sent by an asynchronous refresh, allocated on first use
     uint8_t pixel_buf[];
 } led_strip_rmt_obj;
 
+// store a pixel given in GRB(W) order, marking it for the next refresh only if its color changes
+static inline void led_strip_rmt_write_pixel(led_strip_rmt_obj *rmt_strip, uint32_t index, const uint8_t *grbw)
+{
+    uint8_t *buf = rmt_strip->pixel_buf + index * rmt_strip->bytes_per_pixel;
+    if (memcmp(buf, grbw, rmt_strip->bytes_per_pixel) != 0) {
+        memcpy(buf, grbw, rmt_strip->bytes_per_pixel);
+        if (index >= rmt_strip->dirty_len) {
+            rmt_strip->dirty_len = index + 1;
+        }
+    }
+}
+
 static esp_err_t led_strip_rmt_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
-    uint32_t start = index * rmt_strip->bytes_per_pixel;
     // In thr order of GRB, as LED strip like WS2812 sends out pixels in this order
-    rmt_strip->pixel_buf[start + 0] = green & 0xFF;
-    rmt_strip->pixel_buf[start + 1] = red & 0xFF;
-    rmt_strip->pixel_buf[start + 2] = blue & 0xFF;
-    if (rmt_strip->bytes_per_pixel > 3) {
-        rmt_strip->pixel_buf[start + 3] = 0;
-    }
+    uint8_t pixel[4] = { green & 0xFF, red & 0xFF, blue & 0xFF, 0 };
+    led_strip_rmt_write_pixel(rmt_strip, index, pixel);
     return ESP_OK;
 }
 
@@ -53,12 +67,36 @@ static esp_err_t led_strip_rmt_set_pixel_rgbw(led_strip_t *strip, uint32_t index
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
     ESP_RETURN_ON_FALSE(index < rmt_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
     ESP_RETURN_ON_FALSE(rmt_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
-    uint8_t *buf_start = rmt_strip->pixel_buf + index * 4;
     // SK6812 component order is GRBW
-    *buf_start = green & 0xFF;
-    *++buf_start = red & 0xFF;
-    *++buf_start = blue & 0xFF;
-    *++buf_start = white & 0xFF;
+    uint8_t pixel[4] = { green & 0xFF, red & 0xFF, blue & 0xFF, white & 0xFF };
+    led_strip_rmt_write_pixel(rmt_strip, index, pixel);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *rgb)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_FALSE(start <= rmt_strip->strip_len && count <= rmt_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "pixels out of maximum number of LEDs");
+    // pixel_buf is in the GRB order the strip sends, so red and green swap places on the way in
+    for (uint32_t i = 0; i < count; i++, rgb += 3) {
+        uint8_t pixel[4] = { rgb[1], rgb[0], rgb[2], 0 };
+        led_strip_rmt_write_pixel(rmt_strip, start + i, pixel);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_rmt_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    if (!rmt_strip->enabled) {
+        return ESP_OK;
+    }
+    esp_err_t ret = rmt_tx_wait_all_done(rmt_strip->rmt_chan, timeout_ms);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    rmt_strip->enabled = false;
     return ESP_OK;
 }
 
@@ -69,27 +107,94 @@ static esp_err_t led_strip_rmt_refresh(led_strip_t *strip)
         .loop_count = 0,
     };
 
-    ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+    // nothing changed since the last refresh, the LEDs show this frame once any refresh in flight is out
+    if (rmt_strip->dirty_len == 0) {
+        return led_strip_rmt_wait_refresh_done(strip, -1);
+    }
+    // an asynchronous refresh may have left the channel enabled, this frame then queues behind it
+    if (!rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
+    // LEDs latch the first pixels they receive and keep their color otherwise, so only the changed prefix is sent
     ESP_RETURN_ON_ERROR(rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->pixel_buf,
-                                     rmt_strip->strip_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
+                                     rmt_strip->dirty_len * rmt_strip->bytes_per_pixel, &tx_conf), TAG, "transmit pixels by RMT failed");
     ESP_RETURN_ON_ERROR(rmt_tx_wait_all_done(rmt_strip->rmt_chan, -1), TAG, "flush RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_disable(rmt_strip->rmt_chan), TAG, "disable RMT channel failed");
+    rmt_strip->enabled = false;
+    rmt_strip->dirty_len = 0;
+    return ESP_OK;
+}
+
+static IRAM_ATTR bool led_strip_rmt_trans_done(rmt_channel_handle_t tx_chan, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = (led_strip_rmt_obj *)user_ctx;
+    // also called for synchronous refreshes, only an asynchronous one has a callback to run
+    if (!rmt_strip->async_pending) {
+        return false;
+    }
+    rmt_strip->async_pending = false;
+    if (rmt_strip->done_cb) {
+        return rmt_strip->done_cb(&rmt_strip->base, rmt_strip->done_ctx);
+    }
+    return false;
+}
+
+static esp_err_t led_strip_rmt_refresh_async(led_strip_t *strip, led_strip_refresh_done_cb_t done_cb, void *user_ctx)
+{
+    led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    rmt_transmit_config_t tx_conf = {
+        .loop_count = 0,
+    };
+    size_t len = rmt_strip->dirty_len * rmt_strip->bytes_per_pixel;
+
+    ESP_RETURN_ON_FALSE(!rmt_strip->async_pending, ESP_ERR_INVALID_STATE, TAG, "previous refresh still in progress");
+    // nothing changed since the last refresh, there is no frame to send
+    if (len == 0) {
+        if (done_cb) {
+            done_cb(strip, user_ctx);
+        }
+        return ESP_OK;
+    }
+    if (rmt_strip->tx_buf == NULL) {
+        rmt_strip->tx_buf = malloc(rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+        ESP_RETURN_ON_FALSE(rmt_strip->tx_buf, ESP_ERR_NO_MEM, TAG, "no mem for transmit buffer");
+    }
+    // the frame is sent from its own buffer, so pixels can be set for the next frame meanwhile
+    memcpy(rmt_strip->tx_buf, rmt_strip->pixel_buf, len);
+    rmt_strip->done_cb = done_cb;
+    rmt_strip->done_ctx = user_ctx;
+
+    if (!rmt_strip->enabled) {
+        ESP_RETURN_ON_ERROR(rmt_enable(rmt_strip->rmt_chan), TAG, "enable RMT channel failed");
+        rmt_strip->enabled = true;
+    }
+    rmt_strip->async_pending = true;
+    esp_err_t ret = rmt_transmit(rmt_strip->rmt_chan, rmt_strip->strip_encoder, rmt_strip->tx_buf, len, &tx_conf);
+    if (ret != ESP_OK) {
+        rmt_strip->async_pending = false;
+    }
+    ESP_RETURN_ON_ERROR(ret, TAG, "transmit pixels by RMT failed");
+    rmt_strip->dirty_len = 0;
     return ESP_OK;
 }
 
 static esp_err_t led_strip_rmt_clear(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
-    // Write zero to turn off all leds
+    // Write zero to turn off all leds, all of them are sent even if they look off already
     memset(rmt_strip->pixel_buf, 0, rmt_strip->strip_len * rmt_strip->bytes_per_pixel);
+    rmt_strip->dirty_len = rmt_strip->strip_len;
     return led_strip_rmt_refresh(strip);
 }
 
 static esp_err_t led_strip_rmt_del(led_strip_t *strip)
 {
     led_strip_rmt_obj *rmt_strip = __containerof(strip, led_strip_rmt_obj, base);
+    ESP_RETURN_ON_ERROR(led_strip_rmt_wait_refresh_done(strip, -1), TAG, "wait for refresh failed");
     ESP_RETURN_ON_ERROR(rmt_del_channel(rmt_strip->rmt_chan), TAG, "delete RMT channel failed");
     ESP_RETURN_ON_ERROR(rmt_del_encoder(rmt_strip->strip_encoder), TAG, "delete strip encoder failed");
+    free(rmt_strip->tx_buf);
     free(rmt_strip);
     return ESP_OK;
 }
@@ -132,6 +237,10 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
         .flags.invert_out = led_config->flags.invert_out,
     };
     ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&rmt_chan_config, &rmt_strip->rmt_chan), err, TAG, "create RMT TX channel failed");
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = led_strip_rmt_trans_done,
+    };
+    ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(rmt_strip->rmt_chan, &cbs, rmt_strip), err, TAG, "register RMT callbacks failed");
 
     led_strip_encoder_config_t strip_encoder_conf = {
         .resolution = resolution,
@@ -142,9 +251,13 @@ esp_err_t led_strip_new_rmt_device(const led_strip_config_t *led_config, const l
 
     rmt_strip->bytes_per_pixel = bytes_per_pixel;
     rmt_strip->strip_len = led_config->max_leds;
+    rmt_strip->dirty_len = led_config->max_leds;
     rmt_strip->base.set_pixel = led_strip_rmt_set_pixel;
     rmt_strip->base.set_pixel_rgbw = led_strip_rmt_set_pixel_rgbw;
+    rmt_strip->base.set_pixels = led_strip_rmt_set_pixels;
     rmt_strip->base.refresh = led_strip_rmt_refresh;
+    rmt_strip->base.refresh_async = led_strip_rmt_refresh_async;
+    rmt_strip->base.wait_refresh_done = led_strip_rmt_wait_refresh_done;
     rmt_strip->base.clear = led_strip_rmt_clear;
     rmt_strip->base.del = led_strip_rmt_del;
 
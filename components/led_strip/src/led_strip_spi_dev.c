@@ -0,0 +1,331 @@
+/*
+ * SPDX-FileCopyrightText: 2022-2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <sys/cdefs.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_rom_gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "soc/spi_periph.h"
+#include "led_strip.h"
+#include "led_strip_interface.h"
+#include "hal/spi_hal.h"
+
+#define LED_STRIP_SPI_DEFAULT_RESOLUTION (2.5 * 1000 * 1000) // 2.5MHz resolution
+#define LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE 4
+
+#define SPI_BYTES_PER_COLOR_BYTE 3
+#define SPI_BITS_PER_COLOR_BYTE (SPI_BYTES_PER_COLOR_BYTE * 8)
+
+static const char *TAG = "led_strip_spi";
+
+typedef struct {
+    led_strip_t base;
+    spi_host_device_t spi_host;
+    spi_device_handle_t spi_device;
+    uint32_t strip_len;
+    uint8_t bytes_per_pixel;
+    uint32_t dirty_len;                  // leading pixels changed since the last refresh, the prefix to send
+    uint32_t mem_caps;                   // capabilities of the pixel buffers (DMA capable with DMA)
+    spi_transaction_t async_trans;       // transaction of the asynchronous refresh
+    bool async_pending;                  // asynchronous refresh whose result is not collected yet
+    led_strip_refresh_done_cb_t done_cb; // callback of the asynchronous refresh
+    void *done_ctx;
+    uint8_t *tx_buf;                     // frame being sent by an asynchronous refresh, allocated on first use
+    uint8_t pixel_buf[];
+} led_strip_spi_obj;
+
+// Each color of 1 bit is represented by 3 bits of SPI, low_level:100 ,high_level:110
+// So a color byte occupies 3 bytes of SPI, MSB first: bit n of the color lands in bits 3n+2..3n of the 24-bit pattern
+#define SPI_BIT_PATTERN(data, n) ((uint32_t)(BIT(2) | (((data) >> (n)) & 1) << 1) << (3 * (n)))
+#define SPI_PATTERN(data) (SPI_BIT_PATTERN(data, 0) | SPI_BIT_PATTERN(data, 1) | SPI_BIT_PATTERN(data, 2) | SPI_BIT_PATTERN(data, 3) | \
+                           SPI_BIT_PATTERN(data, 4) | SPI_BIT_PATTERN(data, 5) | SPI_BIT_PATTERN(data, 6) | SPI_BIT_PATTERN(data, 7))
+#define SPI_PATTERN_BYTES(data) { (SPI_PATTERN(data) >> 16) & 0xFF, (SPI_PATTERN(data) >> 8) & 0xFF, SPI_PATTERN(data) & 0xFF }
+#define SPI_PATTERN_BYTES_4(data) SPI_PATTERN_BYTES(data), SPI_PATTERN_BYTES((data) + 1), SPI_PATTERN_BYTES((data) + 2), SPI_PATTERN_BYTES((data) + 3)
+#define SPI_PATTERN_BYTES_16(data) SPI_PATTERN_BYTES_4(data), SPI_PATTERN_BYTES_4((data) + 4), SPI_PATTERN_BYTES_4((data) + 8), SPI_PATTERN_BYTES_4((data) + 12)
+#define SPI_PATTERN_BYTES_64(data) SPI_PATTERN_BYTES_16(data), SPI_PATTERN_BYTES_16((data) + 16), SPI_PATTERN_BYTES_16((data) + 32), SPI_PATTERN_BYTES_16((data) + 48)
+
+// SPI pattern of every color byte, built at compile time
+static const uint8_t s_spi_bit_patterns[256][SPI_BYTES_PER_COLOR_BYTE] = {
+    SPI_PATTERN_BYTES_64(0), SPI_PATTERN_BYTES_64(64), SPI_PATTERN_BYTES_64(128), SPI_PATTERN_BYTES_64(192)
+};
+
+// overwrites the 3 SPI bytes of a color byte, no need to zero-initialize the buf
+static inline void __led_strip_spi_bit(uint8_t data, uint8_t *buf)
+{
+    const uint8_t *pattern = s_spi_bit_patterns[data];
+    buf[0] = pattern[0];
+    buf[1] = pattern[1];
+    buf[2] = pattern[2];
+}
+
+// expand and store a pixel in GRB(W) order, marking it for the next refresh only if its pattern changes
+static inline void led_strip_spi_write_pixel(led_strip_spi_obj *spi_strip, uint32_t index, uint8_t green, uint8_t red, uint8_t blue, uint8_t white)
+{
+    uint32_t len = spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t pixel[SPI_BYTES_PER_COLOR_BYTE * 4];
+    __led_strip_spi_bit(green, pixel);
+    __led_strip_spi_bit(red, pixel + SPI_BYTES_PER_COLOR_BYTE);
+    __led_strip_spi_bit(blue, pixel + SPI_BYTES_PER_COLOR_BYTE * 2);
+    __led_strip_spi_bit(white, pixel + SPI_BYTES_PER_COLOR_BYTE * 3);
+
+    uint8_t *buf = spi_strip->pixel_buf + index * len;
+    if (memcmp(buf, pixel, len) != 0) {
+        memcpy(buf, pixel, len);
+        if (index >= spi_strip->dirty_len) {
+            spi_strip->dirty_len = index + 1;
+        }
+    }
+}
+
+static esp_err_t led_strip_spi_set_pixel(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    // LED_PIXEL_FORMAT_GRB takes 72bits(9bytes)
+    led_strip_spi_write_pixel(spi_strip, index, green, red, blue, 0);
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixel_rgbw(led_strip_t *strip, uint32_t index, uint32_t red, uint32_t green, uint32_t blue, uint32_t white)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(index < spi_strip->strip_len, ESP_ERR_INVALID_ARG, TAG, "index out of maximum number of LEDs");
+    ESP_RETURN_ON_FALSE(spi_strip->bytes_per_pixel == 4, ESP_ERR_INVALID_ARG, TAG, "wrong LED pixel format, expected 4 bytes per pixel");
+    // LED_PIXEL_FORMAT_GRBW takes 96bits(12bytes)
+    // SK6812 component order is GRBW
+    led_strip_spi_write_pixel(spi_strip, index, green, red, blue, white);
+
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_set_pixels(led_strip_t *strip, uint32_t start, uint32_t count, const uint8_t *rgb)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    ESP_RETURN_ON_FALSE(start <= spi_strip->strip_len && count <= spi_strip->strip_len - start, ESP_ERR_INVALID_ARG, TAG, "pixels out of maximum number of LEDs");
+    // GRB(W) order on the wire, each color byte expanded through the pattern table
+    for (uint32_t i = 0; i < count; i++, rgb += 3) {
+        led_strip_spi_write_pixel(spi_strip, start + i, rgb[1], rgb[0], rgb[2], 0);
+    }
+    return ESP_OK;
+}
+
+// collect the result of a queued asynchronous refresh, the driver needs it before the next transaction
+static esp_err_t led_strip_spi_collect(led_strip_spi_obj *spi_strip, TickType_t ticks_to_wait)
+{
+    if (!spi_strip->async_pending) {
+        return ESP_OK;
+    }
+    spi_transaction_t *done_trans = NULL;
+    esp_err_t ret = spi_device_get_trans_result(spi_strip->spi_device, &done_trans, ticks_to_wait);
+    if (ret == ESP_OK) {
+        spi_strip->async_pending = false;
+    }
+    return ret;
+}
+
+static esp_err_t led_strip_spi_refresh(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    spi_transaction_t tx_conf;
+    memset(&tx_conf, 0, sizeof(tx_conf));
+
+    ESP_RETURN_ON_ERROR(led_strip_spi_collect(spi_strip, portMAX_DELAY), TAG, "wait for previous refresh failed");
+    // nothing changed since the last refresh, the LEDs already show this frame
+    if (spi_strip->dirty_len == 0) {
+        return ESP_OK;
+    }
+
+    // LEDs latch the first pixels they receive and keep their color otherwise, so only the changed prefix is sent
+    tx_conf.length = spi_strip->dirty_len * spi_strip->bytes_per_pixel * SPI_BITS_PER_COLOR_BYTE;
+    tx_conf.tx_buffer = spi_strip->pixel_buf;
+    tx_conf.rx_buffer = NULL;
+    ESP_RETURN_ON_ERROR(spi_device_transmit(spi_strip->spi_device, &tx_conf), TAG, "transmit pixels by SPI failed");
+    spi_strip->dirty_len = 0;
+
+    return ESP_OK;
+}
+
+// post transaction callback of the device, called from the SPI ISR
+static IRAM_ATTR void led_strip_spi_trans_done(spi_transaction_t *trans)
+{
+    // only asynchronous refreshes carry the strip
+    led_strip_spi_obj *spi_strip = (led_strip_spi_obj *)trans->user;
+    if (spi_strip && spi_strip->done_cb && spi_strip->done_cb(&spi_strip->base, spi_strip->done_ctx)) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static esp_err_t led_strip_spi_refresh_async(led_strip_t *strip, led_strip_refresh_done_cb_t done_cb, void *user_ctx)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    size_t len = spi_strip->dirty_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+
+    ESP_RETURN_ON_FALSE(led_strip_spi_collect(spi_strip, 0) == ESP_OK, ESP_ERR_INVALID_STATE, TAG, "previous refresh still in progress");
+    // nothing changed since the last refresh, there is no frame to send
+    if (len == 0) {
+        if (done_cb) {
+            done_cb(strip, user_ctx);
+        }
+        return ESP_OK;
+    }
+    if (spi_strip->tx_buf == NULL) {
+        spi_strip->tx_buf = heap_caps_malloc(spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE, spi_strip->mem_caps);
+        ESP_RETURN_ON_FALSE(spi_strip->tx_buf, ESP_ERR_NO_MEM, TAG, "no mem for transmit buffer");
+    }
+    // the frame is sent from its own buffer, so pixels can be set for the next frame meanwhile
+    memcpy(spi_strip->tx_buf, spi_strip->pixel_buf, len);
+    spi_strip->done_cb = done_cb;
+    spi_strip->done_ctx = user_ctx;
+
+    memset(&spi_strip->async_trans, 0, sizeof(spi_strip->async_trans));
+    spi_strip->async_trans.length = len * 8;
+    spi_strip->async_trans.tx_buffer = spi_strip->tx_buf;
+    spi_strip->async_trans.user = spi_strip;
+    ESP_RETURN_ON_ERROR(spi_device_queue_trans(spi_strip->spi_device, &spi_strip->async_trans, 0), TAG, "queue pixels by SPI failed");
+    spi_strip->async_pending = true;
+    spi_strip->dirty_len = 0;
+    return ESP_OK;
+}
+
+static esp_err_t led_strip_spi_wait_refresh_done(led_strip_t *strip, int32_t timeout_ms)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    return led_strip_spi_collect(spi_strip, timeout_ms < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms));
+}
+
+static esp_err_t led_strip_spi_clear(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+    //Write zero to turn off all leds: the zero pattern is written once, then doubled in place
+    //All of them are sent even if they look off already
+    size_t len = spi_strip->strip_len * spi_strip->bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE;
+    uint8_t *buf = spi_strip->pixel_buf;
+    if (len > 0) {
+        size_t filled = SPI_BYTES_PER_COLOR_BYTE;
+        __led_strip_spi_bit(0, buf);
+        while (filled < len) {
+            size_t chunk = filled < len - filled ? filled : len - filled;
+            memcpy(buf + filled, buf, chunk);
+            filled += chunk;
+        }
+    }
+    spi_strip->dirty_len = spi_strip->strip_len;
+
+    return led_strip_spi_refresh(strip);
+}
+
+static esp_err_t led_strip_spi_del(led_strip_t *strip)
+{
+    led_strip_spi_obj *spi_strip = __containerof(strip, led_strip_spi_obj, base);
+
+    ESP_RETURN_ON_ERROR(led_strip_spi_collect(spi_strip, portMAX_DELAY), TAG, "wait for refresh failed");
+    ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi_strip->spi_device), TAG, "delete spi device failed");
+    ESP_RETURN_ON_ERROR(spi_bus_free(spi_strip->spi_host), TAG, "free spi bus failed");
+
+    free(spi_strip->tx_buf);
+    free(spi_strip);
+    return ESP_OK;
+}
+
+esp_err_t led_strip_new_spi_device(const led_strip_config_t *led_config, const led_strip_spi_config_t *spi_config, led_strip_handle_t *ret_strip)
+{
+    led_strip_spi_obj *spi_strip = NULL;
+    esp_err_t ret = ESP_OK;
+    ESP_GOTO_ON_FALSE(led_config && spi_config && ret_strip, ESP_ERR_INVALID_ARG, err, TAG, "invalid argument");
+    ESP_GOTO_ON_FALSE(led_config->led_pixel_format < LED_PIXEL_FORMAT_INVALID, ESP_ERR_INVALID_ARG, err, TAG, "invalid led_pixel_format");
+    uint8_t bytes_per_pixel = 3;
+    if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRBW) {
+        bytes_per_pixel = 4;
+    } else if (led_config->led_pixel_format == LED_PIXEL_FORMAT_GRB) {
+        bytes_per_pixel = 3;
+    } else {
+        assert(false);
+    }
+    uint32_t mem_caps = MALLOC_CAP_DEFAULT;
+    if (spi_config->flags.with_dma) {
+        // DMA buffer must be placed in internal SRAM
+        mem_caps |= MALLOC_CAP_INTERNAL | MALLOC_CAP_DMA;
+    }
+    spi_strip = heap_caps_calloc(1, sizeof(led_strip_spi_obj) + led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE, mem_caps);
+
+    ESP_GOTO_ON_FALSE(spi_strip, ESP_ERR_NO_MEM, err, TAG, "no mem for spi strip");
+
+    spi_strip->spi_host = spi_config->spi_bus;
+    // for backward compatibility, if the user does not set the clk_src, use the default value
+    spi_clock_source_t clk_src = SPI_CLK_SRC_DEFAULT;
+    if (spi_config->clk_src) {
+        clk_src = spi_config->clk_src;
+    }
+
+    spi_bus_config_t spi_bus_cfg = {
+        .mosi_io_num = led_config->strip_gpio_num,
+        //Only use MOSI to generate the signal, set -1 when other pins are not used.
+        .miso_io_num = -1,
+        .sclk_io_num = -1,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = led_config->max_leds * bytes_per_pixel * SPI_BYTES_PER_COLOR_BYTE,
+    };
+    ESP_GOTO_ON_ERROR(spi_bus_initialize(spi_strip->spi_host, &spi_bus_cfg, spi_config->flags.with_dma ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED), err, TAG, "create SPI bus failed");
+
+    if (led_config->flags.invert_out == true) {
+        esp_rom_gpio_connect_out_signal(led_config->strip_gpio_num, spi_periph_signal[spi_strip->spi_host].spid_out, true, false);
+    }
+
+    spi_device_interface_config_t spi_dev_cfg = {
+        .clock_source = clk_src,
+        .command_bits = 0,
+        .address_bits = 0,
+        .dummy_bits = 0,
+        .clock_speed_hz = LED_STRIP_SPI_DEFAULT_RESOLUTION,
+        .mode = 0,
+        //set -1 when CS is not used
+        .spics_io_num = -1,
+        .queue_size = LED_STRIP_SPI_DEFAULT_TRANS_QUEUE_SIZE,
+        .post_cb = led_strip_spi_trans_done,
+    };
+
+    ESP_GOTO_ON_ERROR(spi_bus_add_device(spi_strip->spi_host, &spi_dev_cfg, &spi_strip->spi_device), err, TAG, "Failed to add spi device");
+    //ensure the reset time is enough
+    esp_rom_delay_us(10);
+    int clock_resolution_khz = 0;
+    spi_device_get_actual_freq(spi_strip->spi_device, &clock_resolution_khz);
+    // TODO: ideally we should decide the SPI_BYTES_PER_COLOR_BYTE by the real clock resolution
+    // But now, let's fixed the resolution, the downside is, we don't support a clock source whose frequency is not multiple of LED_STRIP_SPI_DEFAULT_RESOLUTION
+    // clock_resolution between 2.2MHz to 2.8MHz is supported
+    ESP_GOTO_ON_FALSE((clock_resolution_khz < LED_STRIP_SPI_DEFAULT_RESOLUTION / 1000 + 300) && (clock_resolution_khz > LED_STRIP_SPI_DEFAULT_RESOLUTION / 1000 - 300), ESP_ERR_NOT_SUPPORTED, err,
+                      TAG, "unsupported clock resolution:%dKHz", clock_resolution_khz);
+
+    spi_strip->bytes_per_pixel = bytes_per_pixel;
+    spi_strip->strip_len = led_config->max_leds;
+    spi_strip->dirty_len = led_config->max_leds;
+    spi_strip->mem_caps = mem_caps;
+    spi_strip->base.set_pixel = led_strip_spi_set_pixel;
+    spi_strip->base.set_pixel_rgbw = led_strip_spi_set_pixel_rgbw;
+    spi_strip->base.set_pixels = led_strip_spi_set_pixels;
+    spi_strip->base.refresh = led_strip_spi_refresh;
+    spi_strip->base.refresh_async = led_strip_spi_refresh_async;
+    spi_strip->base.wait_refresh_done = led_strip_spi_wait_refresh_done;
+    spi_strip->base.clear = led_strip_spi_clear;
+    spi_strip->base.del = led_strip_spi_del;
+
+    *ret_strip = &spi_strip->base;
+    return ESP_OK;
+err:
+    if (spi_strip) {
+        if (spi_strip->spi_device) {
+            spi_bus_remove_device(spi_strip->spi_device);
+        }
+        if (spi_strip->spi_host) {
+            spi_bus_free(spi_strip->spi_host);
+        }
+        free(spi_strip);
+    }
+    return ret;
+}
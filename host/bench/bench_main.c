@@ -0,0 +1,305 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host micro-benchmarks for the metering, conversion and formatting kernels
+ *
+ * Each benchmark is run until it has used at least the minimum time, then
+ * reported as one JSON object per line (or CSV) with ns/op and allocations/op.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "host_shim.h"
+#include "scene_gen.h"
+#include "led_control.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "frame_pool.h"
+#include "lightmeter_git_rev.h"     // Generated at build time
+
+#ifndef LIGHTMETER_GIT_REV
+#define LIGHTMETER_GIT_REV "unknown"
+#endif
+
+// Firmware globals used by the formatting benchmark (main.c)
+extern light_frame_t *latest_frame;
+void print_detailed_measurements(void);
+
+#define CORPUS_FRAMES   256
+
+// Frame corpus and its expanded views
+static light_frame_t corpus[CORPUS_FRAMES];
+static led_measurement_t corpus_detailed[CORPUS_FRAMES][5][4];
+static float corpus_lux[CORPUS_FRAMES][5][4];
+static float corpus_ev[CORPUS_FRAMES];
+
+// Keeps results alive so the kernels are not optimized away
+static volatile float sink_f;
+static volatile int sink_i;
+
+// Allocation counting (malloc family interposed below)
+static atomic_bool count_allocs = false;
+static atomic_ulong alloc_count = 0;
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    if (atomic_load_explicit(&count_allocs, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    }
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    if (atomic_load_explicit(&count_allocs, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    }
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    if (atomic_load_explicit(&count_allocs, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+
+/* ---- Kernels, one operation per call ---- */
+
+static metering_mode_t bench_mode;
+
+static void bench_convert_to_lux(size_t i) {
+    sink_f = convert_to_lux(corpus[i % CORPUS_FRAMES].raw[i % FRAME_PIXELS]);
+}
+
+static void bench_get_voltage_from_adc(size_t i) {
+    sink_f = get_voltage_from_adc(corpus[i % CORPUS_FRAMES].raw[i % FRAME_PIXELS]);
+}
+
+static void bench_lux_from_raw(size_t i) {
+    sink_f = light_frame_lux_from_raw(corpus[i % CORPUS_FRAMES].raw[i % FRAME_PIXELS]);
+}
+
+static void bench_frame_to_measurements(size_t i) {
+    led_measurement_t view[5][4];
+    light_frame_to_measurements(&corpus[i % CORPUS_FRAMES], view);
+    sink_f = view[2][1].lux;
+}
+
+static void bench_frame_to_lux_matrix(size_t i) {
+    float view[5][4];
+    light_frame_to_lux_matrix(&corpus[i % CORPUS_FRAMES], view);
+    sink_f = view[2][1];
+}
+
+static void bench_calculate_ev(size_t i) {
+    sink_f = calculate_ev(corpus_lux[i % CORPUS_FRAMES], bench_mode);
+}
+
+static void bench_calculate_ev_from_detailed(size_t i) {
+    sink_f = calculate_ev_from_detailed(corpus_detailed[i % CORPUS_FRAMES], bench_mode);
+}
+
+static void bench_calculate_ev_from_frame(size_t i) {
+    sink_f = calculate_ev_from_frame(&corpus[i % CORPUS_FRAMES], bench_mode);
+}
+
+static void bench_calculate_shutter_speed(size_t i) {
+    sink_f = calculate_shutter_speed(corpus_ev[i % CORPUS_FRAMES], 100);
+}
+
+static void bench_exposure_recommendation(size_t i) {
+    char buffer[100];
+    get_exposure_recommendation(corpus_ev[i % CORPUS_FRAMES], 100, buffer, sizeof(buffer));
+    sink_i = buffer[0];
+}
+
+static void bench_print_detailed_measurements(size_t i) {
+    *latest_frame = corpus[i % CORPUS_FRAMES];
+    print_detailed_measurements();
+}
+
+/* ---- Harness ---- */
+
+typedef struct {
+    const char *name;
+    void (*fn)(size_t i);
+    int mode;           // Metering mode, or -1 when not applicable
+} bench_t;
+
+static const bench_t benches[] = {
+    { "convert_to_lux",              bench_convert_to_lux,              -1 },
+    { "get_voltage_from_adc",        bench_get_voltage_from_adc,        -1 },
+    { "light_frame_lux_from_raw",    bench_lux_from_raw,                -1 },
+    { "light_frame_to_measurements", bench_frame_to_measurements,       -1 },
+    { "light_frame_to_lux_matrix",   bench_frame_to_lux_matrix,         -1 },
+    { "calculate_ev",                bench_calculate_ev,                METERING_CENTER_WEIGHTED },
+    { "calculate_ev",                bench_calculate_ev,                METERING_MATRIX },
+    { "calculate_ev",                bench_calculate_ev,                METERING_SPOT },
+    { "calculate_ev",                bench_calculate_ev,                METERING_HIGHLIGHT },
+    { "calculate_ev_from_detailed",  bench_calculate_ev_from_detailed,  METERING_CENTER_WEIGHTED },
+    { "calculate_ev_from_detailed",  bench_calculate_ev_from_detailed,  METERING_MATRIX },
+    { "calculate_ev_from_detailed",  bench_calculate_ev_from_detailed,  METERING_SPOT },
+    { "calculate_ev_from_detailed",  bench_calculate_ev_from_detailed,  METERING_HIGHLIGHT },
+    { "calculate_ev_from_frame",     bench_calculate_ev_from_frame,     METERING_CENTER_WEIGHTED },
+    { "calculate_ev_from_frame",     bench_calculate_ev_from_frame,     METERING_MATRIX },
+    { "calculate_ev_from_frame",     bench_calculate_ev_from_frame,     METERING_SPOT },
+    { "calculate_ev_from_frame",     bench_calculate_ev_from_frame,     METERING_HIGHLIGHT },
+    { "calculate_shutter_speed",     bench_calculate_shutter_speed,     -1 },
+    { "get_exposure_recommendation", bench_exposure_recommendation,     -1 },
+    { "print_detailed_measurements", bench_print_detailed_measurements, -1 },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Fill the corpus with frames of synthetic scenes from every family across the metering range
+ */
+static void build_corpus(uint32_t seed) {
+    scene_rng_t rng;
+    scene_t scene;
+    scene_adc_model_t adc = SCENE_ADC_MODEL_DEFAULT;
+
+    scene_rng_seed(&rng, seed);
+
+    for (int f = 0; f < CORPUS_FRAMES; f++) {
+        scene_random(&scene, (scene_kind_t)(f % SCENE_KIND_COUNT), &rng);
+        scene_sample_frame(&scene, &adc, &rng, 0, 0, &corpus[f]);
+        light_frame_to_measurements(&corpus[f], corpus_detailed[f]);
+        light_frame_to_lux_matrix(&corpus[f], corpus_lux[f]);
+        corpus_ev[f] = calculate_ev_from_frame(&corpus[f], METERING_CENTER_WEIGHTED);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --filter <text>      Only run benchmarks whose name contains text\n"
+            "  --min-time <ms>      Minimum measured time per benchmark (default: 200)\n"
+            "  --seed <value>       Corpus seed (default: 1)\n"
+            "  --csv                Write CSV instead of JSON lines\n"
+            "  --with-logs          Keep INFO logging enabled inside the kernels\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *filter = NULL;
+    double min_time_ns = 200e6;
+    uint32_t seed = 1;
+    bool csv = false;
+    bool with_logs = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--filter") == 0 && value) {
+            filter = value;
+            i++;
+        } else if (strcmp(argv[i], "--min-time") == 0 && value) {
+            min_time_ns = strtod(value, NULL) * 1e6;
+            i++;
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            seed = (uint32_t)strtoul(value, NULL, 0);
+            i++;
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else if (strcmp(argv[i], "--with-logs") == 0) {
+            with_logs = true;
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    host_shim_set_realtime(false);
+    host_shim_set_log_level(ESP_LOG_NONE);
+
+    led_control_init();
+    adc_reader_init();
+    frame_pool_init();
+    latest_frame = frame_pool_acquire();
+    build_corpus(seed);
+
+    host_shim_set_log_level(with_logs ? ESP_LOG_INFO : ESP_LOG_NONE);
+
+    // Kernel output goes to /dev/null; results go to a copy of the original stdout
+    FILE *out = fdopen(dup(fileno(stdout)), "w");
+    if (out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        perror("redirecting stdout");
+        return 1;
+    }
+
+    if (csv) {
+        fprintf(out, "rev,name,mode,iterations,ns_per_op,allocs_per_op\n");
+    }
+
+    for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++) {
+        const bench_t *bench = &benches[b];
+
+        if (filter != NULL && strstr(bench->name, filter) == NULL) {
+            continue;
+        }
+
+        bench_mode = (bench->mode >= 0) ? (metering_mode_t)bench->mode : METERING_CENTER_WEIGHTED;
+        const char *mode_name = (bench->mode >= 0) ? get_metering_mode_name(bench_mode) : "";
+
+        // Warm up, then grow the iteration count until the minimum time is reached
+        for (size_t i = 0; i < 1000; i++) {
+            bench->fn(i);
+        }
+
+        size_t iterations = 1000;
+        double elapsed = 0.0;
+        unsigned long allocs = 0;
+
+        for (;;) {
+            atomic_store(&alloc_count, 0);
+            atomic_store(&count_allocs, true);
+            double start = now_ns();
+            for (size_t i = 0; i < iterations; i++) {
+                bench->fn(i);
+            }
+            elapsed = now_ns() - start;
+            atomic_store(&count_allocs, false);
+            allocs = atomic_load(&alloc_count);
+
+            if (elapsed >= min_time_ns || iterations >= ((size_t)1 << 32)) {
+                break;
+            }
+            iterations *= (elapsed > 0.0 && min_time_ns / elapsed < 10.0) ? 2 : 10;
+        }
+
+        double ns_per_op = elapsed / iterations;
+        double allocs_per_op = (double)allocs / iterations;
+
+        if (csv) {
+            fprintf(out, "%s,%s,%s,%zu,%.2f,%.4f\n", LIGHTMETER_GIT_REV, bench->name, mode_name,
+                    iterations, ns_per_op, allocs_per_op);
+        } else {
+            fprintf(out, "{\"rev\":\"%s\",\"name\":\"%s\",\"mode\":\"%s\",\"iterations\":%zu,"
+                    "\"ns_per_op\":%.2f,\"allocs_per_op\":%.4f}\n",
+                    LIGHTMETER_GIT_REV, bench->name, mode_name, iterations, ns_per_op, allocs_per_op);
+        }
+        fflush(out);
+    }
+
+    fclose(out);
+    return 0;
+}
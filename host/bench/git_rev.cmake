@@ -0,0 +1,38 @@
+# Writes the source revision header for the benchmarks; run at build time so
+# every build is tagged with the checkout it was built from:
+#   cmake -DSOURCE_DIR=<repo> -DOUTPUT=<header> -P git_rev.cmake
+# The header is only rewritten when the revision changes, so an unchanged tree
+# does not rebuild the benchmarks.
+
+execute_process(
+    COMMAND git rev-parse --short HEAD
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE rev
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    RESULT_VARIABLE result
+    ERROR_QUIET
+)
+
+if(NOT result EQUAL 0 OR NOT rev)
+    set(rev unknown)
+else()
+    # Uncommitted changes to tracked files
+    execute_process(
+        COMMAND git status --porcelain --untracked-files=no
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE changes
+        ERROR_QUIET
+    )
+    if(changes)
+        set(rev ${rev}-dirty)
+    endif()
+endif()
+
+set(content "#define LIGHTMETER_GIT_REV \"${rev}\"\n")
+set(previous "")
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+endif()
+if(NOT content STREQUAL previous)
+    file(WRITE ${OUTPUT} "${content}")
+endif()
@@ -0,0 +1,544 @@
+/*
+ * 4x5 Camera Light Meter
+ * Meter daemon: owns the device's serial port and shares it over a Unix socket
+ *
+ * The console stream is decoded once (host/decode) and fanned out to every
+ * subscribed client; commands from clients are queued, sent one at a time and
+ * their output is returned tagged with the client's request ID.
+ *
+ * Client protocol, one line per message:
+ *   SUBSCRIBE [records] [lines] [rate=<hz>] [format=text|jsonl]
+ *       records: REC records in the chosen format (default text), whatever the
+ *                device's own output format; rate limits them per client
+ *       lines:   other console output, as LINE <text>
+ *   CMD <id> <command>  ->  RESP <id> <line> for each line of output, then DONE <id> ok|timeout
+ *                           ('start measure' includes its measurement report)
+ *   STATS               ->  STATS clients=<n> records=<n> sent=<n> dropped=<n>
+ * The daemon also sends EVENT connected|disconnected as the serial link comes and goes.
+ * A client that cannot keep up loses records (counted as dropped) rather than
+ * stalling the others.
+ */
+
+#define _GNU_SOURCE     // cfmakeraw
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "meter_stream.h"
+
+#define MAX_CLIENTS         32
+#define CLIENT_IN_MAX       512
+#define CLIENT_OUT_MAX      (64 * 1024)
+#define MAX_PENDING_CMDS    64
+#define RECONNECT_MS        1000
+
+typedef struct {
+    int fd;
+    char in[CLIENT_IN_MAX];
+    size_t in_len;
+    char out[CLIENT_OUT_MAX];
+    size_t out_len;
+
+    // Subscription
+    bool records;
+    bool lines;
+    frame_format_t format;
+    int64_t min_interval_us;
+    int64_t last_record_us;
+
+    uint64_t sent;
+    uint64_t dropped;
+} client_t;
+
+typedef struct {
+    int client;             // Index into clients, -1 once the client has gone
+    char id[32];
+    char command[128];
+} command_t;
+
+static client_t clients[MAX_CLIENTS];
+static int client_count = 0;
+
+static command_t pending[MAX_PENDING_CMDS];
+static int pending_count = 0;
+static bool command_active = false;
+static int64_t command_deadline_us;
+static uint64_t prompt_baseline;
+static int64_t command_timeout_us = 30 * 1000000LL;
+
+static meter_stream_t stream;
+static int serial_fd = -1;
+static const char *serial_path;
+static const char *socket_path;
+static uint64_t record_count = 0;
+static volatile sig_atomic_t stop = 0;
+
+static int64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+/**
+ * Queue a message for a client; returns false if its buffer is full
+ */
+static bool client_send(client_t *client, const char *format, ...) {
+    size_t room = CLIENT_OUT_MAX - client->out_len;
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(client->out + client->out_len, room, format, args);
+    va_end(args);
+
+    if (len < 0 || (size_t)len >= room) {
+        return false;
+    }
+    client->out_len += len;
+    return true;
+}
+
+/**
+ * Write as much queued output as the socket accepts
+ */
+static bool client_flush(client_t *client) {
+    while (client->out_len > 0) {
+        ssize_t n = send(client->fd, client->out, client->out_len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        memmove(client->out, client->out + n, client->out_len - n);
+        client->out_len -= n;
+    }
+    return true;
+}
+
+static void broadcast(const char *message) {
+    for (int i = 0; i < client_count; i++) {
+        client_send(&clients[i], "%s\n", message);
+    }
+}
+
+/**
+ * Fan a decoded record out to subscribers, formatting it at most once per format
+ */
+static void on_record(const frame_record_t *record, frame_format_t format, void *ctx) {
+    char lines[2][FRAME_RECORD_LINE_MAX];
+    bool formatted[2] = { false, false };
+    int64_t now = now_us();
+
+    (void)format;
+    (void)ctx;
+    record_count++;
+
+    for (int i = 0; i < client_count; i++) {
+        client_t *client = &clients[i];
+        int f = client->format == FRAME_FORMAT_JSONL ? 1 : 0;
+
+        if (!client->records) {
+            continue;
+        }
+        if (client->min_interval_us > 0 && now - client->last_record_us < client->min_interval_us) {
+            continue;
+        }
+
+        if (!formatted[f]) {
+            int len = f ? frame_record_format_json(record, lines[f], sizeof(lines[f]))
+                        : frame_record_format(record, lines[f], sizeof(lines[f]));
+            if (len < 0) {
+                return;
+            }
+            formatted[f] = true;
+        }
+
+        if (client_send(client, "%s\n", lines[f])) {
+            client->last_record_us = now;
+            client->sent++;
+        } else {
+            client->dropped++;
+        }
+    }
+}
+
+/**
+ * Route other console output: to the client whose command is running, and to line subscribers
+ */
+static void on_line(const char *line, size_t length, void *ctx) {
+    (void)ctx;
+
+    // 'start measure' is answered at once, then the report follows ending in a
+    // prompt of its own: the command runs until that one, so the report goes to
+    // its request rather than the next queued command
+    static const char measure_started[] = "Measurement started";
+    if (command_active && length == strlen(measure_started) && memcmp(line, measure_started, length) == 0) {
+        prompt_baseline++;
+    }
+
+    if (command_active && pending[0].client >= 0) {
+        command_t *cmd = &pending[0];
+        client_t *client = &clients[cmd->client];
+
+        // Skip the device's echo of the command
+        if (!(length == strlen(cmd->command) && memcmp(line, cmd->command, length) == 0)) {
+            client_send(client, "RESP %s %.*s\n", cmd->id, (int)length, line);
+        }
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        if (clients[i].lines) {
+            client_send(&clients[i], "LINE %.*s\n", (int)length, line);
+        }
+    }
+}
+
+/**
+ * Open the serial port (or PTY) in raw mode
+ */
+static bool open_serial(void) {
+    serial_fd = open(serial_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (serial_fd < 0) {
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(serial_fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tcsetattr(serial_fd, TCSANOW, &tio);
+    }
+
+    fprintf(stderr, "Connected to %s\n", serial_path);
+    broadcast("EVENT connected");
+    return true;
+}
+
+static void complete_command(const char *status);
+static void send_next_command(void);
+
+/**
+ * Close a lost port; the running command fails and queued ones wait for the reconnect
+ */
+static void close_serial(void) {
+    close(serial_fd);
+    serial_fd = -1;
+    complete_command("disconnected");
+    fprintf(stderr, "Lost %s, retrying\n", serial_path);
+    broadcast("EVENT disconnected");
+}
+
+/**
+ * Finish the running command and send the next queued one
+ */
+static void complete_command(const char *status) {
+    if (command_active) {
+        if (pending[0].client >= 0) {
+            client_send(&clients[pending[0].client], "DONE %s %s\n", pending[0].id, status);
+        }
+        memmove(&pending[0], &pending[1], (pending_count - 1) * sizeof(pending[0]));
+        pending_count--;
+        command_active = false;
+    }
+    send_next_command();
+}
+
+/**
+ * Send the oldest queued command unless one is already running
+ */
+static void send_next_command(void) {
+    while (!command_active && pending_count > 0 && serial_fd >= 0) {
+        command_t *cmd = &pending[0];
+        char line[sizeof(cmd->command) + 1];
+        int len = snprintf(line, sizeof(line), "%s\n", cmd->command);
+
+        if (write(serial_fd, line, len) != len) {
+            if (cmd->client >= 0) {
+                client_send(&clients[cmd->client], "DONE %s error\n", cmd->id);
+            }
+            memmove(&pending[0], &pending[1], (pending_count - 1) * sizeof(pending[0]));
+            pending_count--;
+            continue;
+        }
+
+        // The command is answered when the next prompt appears; a prompt already
+        // waiting is counted once its line completes, so it must not end this one
+        prompt_baseline = stream.stats.prompts + (meter_stream_at_prompt(&stream) ? 1 : 0);
+        command_deadline_us = now_us() + command_timeout_us;
+        command_active = true;
+    }
+}
+
+/**
+ * Read device output and check whether the running command has been answered
+ */
+static void service_serial(void) {
+    char buffer[4096];
+    ssize_t n;
+
+    while ((n = read(serial_fd, buffer, sizeof(buffer))) > 0) {
+        meter_stream_feed(&stream, buffer, n);
+    }
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close_serial();
+        return;
+    }
+
+    if (command_active && (stream.stats.prompts > prompt_baseline ||
+                           (meter_stream_at_prompt(&stream) && stream.stats.prompts >= prompt_baseline))) {
+        complete_command("ok");
+    }
+}
+
+/**
+ * Apply a SUBSCRIBE request
+ */
+static void subscribe(client_t *client, char *args) {
+    client->records = false;
+    client->lines = false;
+    client->format = FRAME_FORMAT_TEXT;
+    client->min_interval_us = 0;
+
+    for (char *token = strtok(args, " "); token; token = strtok(NULL, " ")) {
+        if (strcmp(token, "records") == 0) {
+            client->records = true;
+        } else if (strcmp(token, "lines") == 0) {
+            client->lines = true;
+        } else if (strncmp(token, "rate=", 5) == 0) {
+            double hz = strtod(token + 5, NULL);
+            client->min_interval_us = hz > 0 ? (int64_t)(1e6 / hz) : 0;
+        } else if (strcmp(token, "format=jsonl") == 0) {
+            client->format = FRAME_FORMAT_JSONL;
+        } else if (strcmp(token, "format=text") != 0) {
+            client_send(client, "ERROR unknown subscription option %s\n", token);
+            return;
+        }
+    }
+    client_send(client, "OK\n");
+}
+
+/**
+ * Handle one request line from a client
+ */
+static void handle_request(int index, char *line) {
+    client_t *client = &clients[index];
+
+    if (strncmp(line, "SUBSCRIBE", 9) == 0 && (line[9] == ' ' || line[9] == '\0')) {
+        subscribe(client, line + 9);
+    } else if (strncmp(line, "CMD ", 4) == 0) {
+        char *id = line + 4;
+        char *command = strchr(id, ' ');
+
+        if (command == NULL || command - id >= (int)sizeof(pending[0].id) ||
+            strlen(command + 1) >= sizeof(pending[0].command)) {
+            client_send(client, "ERROR usage: CMD <id> <command>\n");
+            return;
+        }
+        if (pending_count == MAX_PENDING_CMDS) {
+            client_send(client, "DONE %.*s busy\n", (int)(command - id), id);
+            return;
+        }
+
+        command_t *cmd = &pending[pending_count++];
+        cmd->client = index;
+        snprintf(cmd->id, sizeof(cmd->id), "%.*s", (int)(command - id), id);
+        snprintf(cmd->command, sizeof(cmd->command), "%s", command + 1);
+        send_next_command();
+    } else if (strcmp(line, "STATS") == 0) {
+        client_send(client, "STATS clients=%d records=%llu sent=%llu dropped=%llu\n", client_count,
+                    (unsigned long long)record_count, (unsigned long long)client->sent,
+                    (unsigned long long)client->dropped);
+    } else if (line[0] != '\0') {
+        client_send(client, "ERROR unknown request\n");
+    }
+}
+
+/**
+ * Drop a client, moving the last one into its slot
+ */
+static void remove_client(int index) {
+    close(clients[index].fd);
+
+    for (int i = 0; i < pending_count; i++) {
+        if (pending[i].client == index) {
+            pending[i].client = -1;
+        } else if (pending[i].client == client_count - 1) {
+            pending[i].client = index;
+        }
+    }
+
+    client_count--;
+    if (index != client_count) {
+        memcpy(&clients[index], &clients[client_count], sizeof(clients[0]));
+    }
+}
+
+/**
+ * Read requests from a client; returns false when it has gone
+ */
+static bool service_client(int index) {
+    client_t *client = &clients[index];
+    ssize_t n = recv(client->fd, client->in + client->in_len, CLIENT_IN_MAX - client->in_len - 1, MSG_DONTWAIT);
+
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        return false;
+    }
+    if (n < 0) {
+        return true;
+    }
+    client->in_len += n;
+    client->in[client->in_len] = '\0';
+
+    char *start = client->in;
+    char *newline;
+    while ((newline = strchr(start, '\n')) != NULL) {
+        *newline = '\0';
+        if (newline > start && newline[-1] == '\r') {
+            newline[-1] = '\0';
+        }
+        handle_request(index, start);
+        start = newline + 1;
+    }
+
+    client->in_len -= start - client->in;
+    memmove(client->in, start, client->in_len);
+    if (client->in_len == CLIENT_IN_MAX - 1) {
+        client_send(client, "ERROR request too long\n");
+        client->in_len = 0;
+    }
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <serial port> <socket path>\n"
+            "  --timeout <s>        Seconds to wait for a command's prompt (default: 30)\n",
+            prog);
+}
+
+static void remove_socket(void) {
+    unlink(socket_path);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--timeout") == 0 && value) {
+            command_timeout_us = (int64_t)(strtod(value, NULL) * 1e6);
+            i++;
+        } else if (argv[i][0] != '-' && serial_path == NULL) {
+            serial_path = argv[i];
+        } else if (argv[i][0] != '-' && socket_path == NULL) {
+            socket_path = argv[i];
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (serial_path == NULL || socket_path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    if (listen_fd < 0 || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Cannot create socket %s\n", socket_path);
+        return 1;
+    }
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", socket_path);
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 8) != 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", socket_path, strerror(errno));
+        return 1;
+    }
+    atexit(remove_socket);
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    meter_stream_init(&stream, on_record, NULL);
+    stream.on_line = on_line;
+
+    int64_t next_open_us = 0;
+    fprintf(stderr, "Serving %s on %s\n", serial_path, socket_path);
+
+    while (!stop) {
+        struct pollfd fds[MAX_CLIENTS + 2];
+        int nfds = 0;
+
+        if (serial_fd < 0 && now_us() >= next_open_us) {
+            if (!open_serial()) {
+                next_open_us = now_us() + RECONNECT_MS * 1000LL;
+            }
+            send_next_command();
+        }
+
+        fds[nfds++] = (struct pollfd){ .fd = listen_fd, .events = POLLIN };
+        fds[nfds++] = (struct pollfd){ .fd = serial_fd, .events = POLLIN };
+        for (int i = 0; i < client_count; i++) {
+            fds[nfds++] = (struct pollfd){
+                .fd = clients[i].fd,
+                .events = POLLIN | (clients[i].out_len ? POLLOUT : 0)
+            };
+        }
+
+        if (poll(fds, nfds, 100) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listen_fd, NULL, NULL);
+            if (fd >= 0 && client_count < MAX_CLIENTS) {
+                client_t *client = &clients[client_count++];
+                memset(client, 0, sizeof(*client));
+                client->fd = fd;
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        if (serial_fd >= 0 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            service_serial();
+        }
+
+        if (command_active && now_us() > command_deadline_us) {
+            complete_command("timeout");
+        }
+
+        // Clients in reverse, so removing one does not skip another
+        for (int i = client_count - 1; i >= 0; i--) {
+            short revents = (i + 2 < nfds && fds[i + 2].fd == clients[i].fd) ? fds[i + 2].revents : 0;
+
+            if ((revents & (POLLIN | POLLHUP | POLLERR)) && !service_client(i)) {
+                remove_client(i);
+                continue;
+            }
+            if (!client_flush(&clients[i])) {
+                remove_client(i);
+            }
+        }
+    }
+
+    for (int i = client_count - 1; i >= 0; i--) {
+        remove_client(i);
+    }
+    return 0;
+}
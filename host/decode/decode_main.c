@@ -0,0 +1,210 @@
+/*
+ * 4x5 Camera Light Meter
+ * Decodes meter console captures: CSV export, stream statistics and CRC checks
+ *
+ * Input is any capture of the console (or a session's raw bytes) holding REC
+ * records in text, JSONL or binary form, as selected by 'config output', plus
+ * optional CAL lines; other output is skipped.
+ */
+
+#include <float.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "light_frame.h"
+#include "light_meter.h"
+#include "meter_stream.h"
+
+#define READ_CHUNK  (1 << 20)
+
+typedef struct {
+    FILE *csv;
+    bool lux;
+    const meter_stream_t *stream;
+    uint64_t records;
+    double ev_sum;
+    float ev_min;
+    float ev_max;
+    uint64_t saturated;
+} decode_state_t;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Write one record as a CSV row and fold it into the summary
+ */
+static void on_record(const frame_record_t *record, frame_format_t format, void *ctx) {
+    decode_state_t *state = ctx;
+
+    state->records++;
+    state->ev_sum += record->ev;
+    if (record->ev < state->ev_min) state->ev_min = record->ev;
+    if (record->ev > state->ev_max) state->ev_max = record->ev;
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        if (record->raw[i] >= ADC_SATURATION_CODE) {
+            state->saturated++;
+        }
+    }
+
+    if (state->csv == NULL) {
+        return;
+    }
+
+    fprintf(state->csv, "%s,%lu,%lld,%d,%s,%.9g,%.9g", frame_record_format_name(format),
+            (unsigned long)record->seq, (long long)record->time_us, record->iso,
+            get_metering_mode_name(record->mode), record->k_value, record->ev);
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        fprintf(state->csv, ",%u", record->raw[i]);
+    }
+    if (state->lux) {
+        for (int i = 0; i < FRAME_PIXELS; i++) {
+            fprintf(state->csv, ",%.1f", lux_from_voltage(meter_stream_mv(state->stream, record->raw[i]) / 1000.0f));
+        }
+    }
+    fputc('\n', state->csv);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [capture file | - ...]\n"
+            "  --csv <file|->       Write records as CSV (format, seq, time, config, EV, raw codes)\n"
+            "  --lux                Add per-pixel lux columns, from the capture's CAL line if any\n"
+            "  --check              Exit 1 on CRC errors, malformed records or sequence gaps\n"
+            "  --quiet              No statistics on stderr\n"
+            "Reads stdin when no capture is given.\n",
+            prog);
+}
+
+/**
+ * Feed one capture through the decoder
+ */
+static bool decode_file(meter_stream_t *stream, const char *path, char *buffer) {
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return false;
+    }
+
+    size_t n;
+    while ((n = fread(buffer, 1, READ_CHUNK, in)) > 0) {
+        meter_stream_feed(stream, buffer, n);
+    }
+    meter_stream_finish(stream);
+
+    bool ok = !ferror(in);
+    if (!ok) {
+        perror(path);
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *csv_path = NULL;
+    const char *paths[64];
+    int path_count = 0;
+    bool check = false;
+    bool quiet = false;
+    decode_state_t state = { .ev_min = FLT_MAX, .ev_max = -FLT_MAX };
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--csv") == 0 && value) {
+            csv_path = value;
+            i++;
+        } else if (strcmp(argv[i], "--lux") == 0) {
+            state.lux = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if ((argv[i][0] != '-' || strcmp(argv[i], "-") == 0) &&
+                   path_count < (int)(sizeof(paths) / sizeof(paths[0]))) {
+            paths[path_count++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+    if (path_count == 0) {
+        paths[path_count++] = "-";
+    }
+
+    if (csv_path) {
+        state.csv = (strcmp(csv_path, "-") == 0) ? stdout : fopen(csv_path, "w");
+        if (state.csv == NULL) {
+            perror(csv_path);
+            return 2;
+        }
+        fprintf(state.csv, "format,seq,time_us,iso,mode,k_value,ev");
+        for (int i = 1; i <= FRAME_PIXELS; i++) {
+            fprintf(state.csv, ",raw_%d", i);
+        }
+        if (state.lux) {
+            for (int i = 1; i <= FRAME_PIXELS; i++) {
+                fprintf(state.csv, ",lux_%d", i);
+            }
+        }
+        fputc('\n', state.csv);
+    }
+
+    static meter_stream_t stream;
+    char *buffer = malloc(READ_CHUNK);
+    if (buffer == NULL) {
+        perror("malloc");
+        return 2;
+    }
+
+    meter_stream_init(&stream, on_record, &state);
+    state.stream = &stream;
+
+    bool read_ok = true;
+    double start = now_ns();
+    for (int i = 0; i < path_count; i++) {
+        read_ok &= decode_file(&stream, paths[i], buffer);
+    }
+    double elapsed = now_ns() - start;
+    free(buffer);
+
+    if (state.csv && state.csv != stdout) {
+        fclose(state.csv);
+    }
+
+    const meter_stream_stats_t *stats = &stream.stats;
+    bool valid = stats->crc_errors == 0 && stats->malformed == 0 && stats->seq_gaps == 0;
+
+    if (!quiet) {
+        double mb = stats->bytes / 1e6;
+        fprintf(stderr, "Decoded %.2f MB in %.1f ms (%.1f MB/s), %llu lines\n",
+                mb, elapsed / 1e6, elapsed > 0 ? mb * 1e9 / elapsed : 0.0,
+                (unsigned long long)stats->lines);
+        fprintf(stderr, "Records: %llu text, %llu jsonl, %llu binary; %llu CAL lines\n",
+                (unsigned long long)stats->records[FRAME_FORMAT_TEXT],
+                (unsigned long long)stats->records[FRAME_FORMAT_JSONL],
+                (unsigned long long)stats->records[FRAME_FORMAT_BINARY],
+                (unsigned long long)stats->calibrations);
+        fprintf(stderr, "Errors: %llu CRC, %llu malformed, %llu missing by sequence, %llu overlong lines\n",
+                (unsigned long long)stats->crc_errors, (unsigned long long)stats->malformed,
+                (unsigned long long)stats->seq_gaps, (unsigned long long)stats->overlong);
+        if (state.records > 0) {
+            fprintf(stderr, "EV: min %.2f, mean %.2f, max %.2f; %llu saturated pixels\n",
+                    state.ev_min, state.ev_sum / state.records, state.ev_max,
+                    (unsigned long long)state.saturated);
+        }
+    }
+
+    if (!read_ok) {
+        return 2;
+    }
+    return (check && !valid) ? 1 : 0;
+}
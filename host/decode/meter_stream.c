@@ -0,0 +1,180 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host decoder for meter console streams
+ */
+
+#include <string.h>
+
+#include "meter_stream.h"
+
+/**
+ * Initialize a decoder; further callbacks can be set on the struct
+ */
+void meter_stream_init(meter_stream_t *stream, meter_record_cb on_record, void *ctx) {
+    memset(stream, 0, sizeof(*stream));
+    stream->on_record = on_record;
+    stream->ctx = ctx;
+}
+
+/**
+ * Count any records skipped since the previous one and pass the record on
+ */
+static void emit_record(meter_stream_t *stream, const frame_record_t *record, frame_format_t format) {
+    if (stream->have_seq && record->seq > stream->last_seq + 1) {
+        stream->stats.seq_gaps += record->seq - stream->last_seq - 1;
+    }
+    stream->have_seq = true;
+    stream->last_seq = record->seq;
+    stream->stats.records[format]++;
+
+    if (stream->on_record) {
+        stream->on_record(record, format, stream->ctx);
+    }
+}
+
+/**
+ * Decode one line (without its newline)
+ * The byte after the line is a newline or NUL, which stops the text parsers
+ */
+static void process_line(meter_stream_t *stream, const char *line, size_t length) {
+    frame_record_t record;
+
+    stream->stats.lines++;
+
+    // A record can follow the console prompt on the same line
+    while (length >= 2 && line[0] == '>' && line[1] == ' ') {
+        line += 2;
+        length -= 2;
+        stream->stats.prompts++;
+    }
+    if (length == 0) {
+        return;
+    }
+
+    if ((uint8_t)line[0] == FRAME_BINARY_SYNC) {
+        bool crc_ok;
+        if (frame_record_decode_binary((const uint8_t *)line, length, &record, &crc_ok)) {
+            emit_record(stream, &record, FRAME_FORMAT_BINARY);
+        } else if (!crc_ok) {
+            stream->stats.crc_errors++;
+        } else {
+            stream->stats.malformed++;
+        }
+    } else if (length >= 4 && memcmp(line, "REC,", 4) == 0) {
+        if (frame_record_parse(line, &record)) {
+            emit_record(stream, &record, FRAME_FORMAT_TEXT);
+        } else {
+            stream->stats.malformed++;
+        }
+    } else if (length >= 6 && memcmp(line, "{\"rec\"", 6) == 0) {
+        if (frame_record_parse_json(line, &record)) {
+            emit_record(stream, &record, FRAME_FORMAT_JSONL);
+        } else {
+            stream->stats.malformed++;
+        }
+    } else if (length >= 4 && memcmp(line, "CAL,", 4) == 0) {
+        int codes = frame_record_parse_calibration(line, stream->mv_table, ADC_CODE_COUNT);
+        if (codes > 0) {
+            stream->codes = codes;
+            stream->stats.calibrations++;
+            if (stream->on_calibration) {
+                stream->on_calibration(stream->mv_table, codes, stream->ctx);
+            }
+        } else {
+            stream->stats.malformed++;
+        }
+    } else if (stream->on_line) {
+        if (line[length - 1] == '\r') {
+            length--;
+        }
+        stream->on_line(line, length, stream->ctx);
+    }
+}
+
+/**
+ * Keep the start of a line that continues in the next feed
+ */
+static void carry_append(meter_stream_t *stream, const char *data, size_t length) {
+    if (stream->discarding) {
+        return;
+    }
+    if (stream->carry_len + length > METER_STREAM_LINE_MAX) {
+        stream->stats.overlong++;
+        stream->discarding = true;
+        stream->carry_len = 0;
+        return;
+    }
+    memcpy(stream->carry + stream->carry_len, data, length);
+    stream->carry_len += length;
+}
+
+/**
+ * Decode the carried line once its newline has arrived
+ */
+static void carry_flush(meter_stream_t *stream) {
+    if (!stream->discarding && stream->carry_len > 0) {
+        stream->carry[stream->carry_len] = '\0';
+        process_line(stream, stream->carry, stream->carry_len);
+    }
+    stream->carry_len = 0;
+    stream->discarding = false;
+}
+
+/**
+ * Decode the next chunk of a stream; chunks may split lines anywhere
+ */
+void meter_stream_feed(meter_stream_t *stream, const void *data, size_t length) {
+    const char *p = data;
+    const char *end = p + length;
+
+    stream->stats.bytes += length;
+
+    // Finish a line left over from the previous chunk
+    if (stream->carry_len > 0 || stream->discarding) {
+        const char *newline = memchr(p, '\n', length);
+        carry_append(stream, p, (newline ? newline : end) - p);
+        if (newline == NULL) {
+            return;
+        }
+        carry_flush(stream);
+        p = newline + 1;
+    }
+
+    // Complete lines are decoded where they lie
+    while (p < end) {
+        const char *newline = memchr(p, '\n', end - p);
+        if (newline == NULL) {
+            carry_append(stream, p, end - p);
+            break;
+        }
+        process_line(stream, p, newline - p);
+        p = newline + 1;
+    }
+}
+
+/**
+ * Decode a final line that has no newline
+ */
+void meter_stream_finish(meter_stream_t *stream) {
+    carry_flush(stream);
+}
+
+/**
+ * Check whether the stream ends in a prompt still waiting for its line
+ * The prompt is counted in stats.prompts once the line completes
+ */
+bool meter_stream_at_prompt(const meter_stream_t *stream) {
+    return !stream->discarding && stream->carry_len == 2 &&
+           stream->carry[0] == '>' && stream->carry[1] == ' ';
+}
+
+/**
+ * Voltage in mV of a raw code, from the stream's CAL line when one was seen
+ * and otherwise as the firmware's uncalibrated conversion
+ */
+float meter_stream_mv(const meter_stream_t *stream, uint16_t raw) {
+    if (raw < stream->codes) {
+        return (float)stream->mv_table[raw];
+    }
+    return raw >= ADC_SATURATION_CODE ? 3300.0f : raw * 3300.0f / ADC_MAX_CODE;
+}
@@ -0,0 +1,68 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host decoder for meter console streams
+ *
+ * Splits a console byte stream into lines and decodes the records defined in
+ * frame_record.h (text REC, JSONL and binary) plus CAL lines, using the
+ * firmware's own parsers. Complete lines are parsed in place in the caller's
+ * buffer; only a line split across two feeds is copied.
+ */
+
+#ifndef METER_STREAM_H
+#define METER_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frame_record.h"
+
+// Longest line kept across feeds (a CAL line is about 4 KB)
+#define METER_STREAM_LINE_MAX   16384
+
+typedef struct {
+    uint64_t bytes;
+    uint64_t lines;
+    uint64_t records[3];        // By frame_format_t
+    uint64_t calibrations;
+    uint64_t malformed;         // Record lines that failed to parse
+    uint64_t crc_errors;        // Binary records with a bad CRC
+    uint64_t seq_gaps;          // Records missing between consecutive sequence numbers
+    uint64_t overlong;          // Lines over METER_STREAM_LINE_MAX, dropped
+    uint64_t prompts;           // Console prompts seen at the start of a line
+} meter_stream_stats_t;
+
+typedef void (*meter_record_cb)(const frame_record_t *record, frame_format_t format, void *ctx);
+typedef void (*meter_calibration_cb)(const int *mv_table, int codes, void *ctx);
+typedef void (*meter_line_cb)(const char *line, size_t length, void *ctx);
+
+typedef struct {
+    // Callbacks, any of which may be NULL
+    meter_record_cb on_record;
+    meter_calibration_cb on_calibration;
+    meter_line_cb on_line;      // Other output (without newline), e.g. command responses
+    void *ctx;
+
+    meter_stream_stats_t stats;
+
+    // Latest calibration, codes is 0 until a CAL line has been seen
+    int mv_table[ADC_CODE_COUNT];
+    int codes;
+
+    bool have_seq;
+    uint32_t last_seq;
+
+    // Partial line carried to the next feed
+    size_t carry_len;
+    bool discarding;
+    char carry[METER_STREAM_LINE_MAX + 1];
+} meter_stream_t;
+
+// Function prototypes
+void meter_stream_init(meter_stream_t *stream, meter_record_cb on_record, void *ctx);
+void meter_stream_feed(meter_stream_t *stream, const void *data, size_t length);
+void meter_stream_finish(meter_stream_t *stream);
+float meter_stream_mv(const meter_stream_t *stream, uint16_t raw);
+bool meter_stream_at_prompt(const meter_stream_t *stream);
+
+#endif // METER_STREAM_H
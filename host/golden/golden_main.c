@@ -0,0 +1,420 @@
+/*
+ * 4x5 Camera Light Meter
+ * Golden-vector accuracy suite for the metering math
+ *
+ *   lightmeter_golden generate [options] > golden.txt
+ *   lightmeter_golden check [options] golden.txt
+ *
+ * 'generate' evaluates the reference float implementation and writes one
+ * vector per line:
+ *   GOLDEN,<version>,<k value>,<frames>,<seed>
+ *   L,<raw>,<lux>                      convert_to_lux() for every ADC code
+ *   E,<mode>,<ev>,<raw 1>,...,<raw 20> calculate_ev_from_detailed() on the float lux path
+ *   S,<ev>,<iso>,<seconds>             calculate_shutter_speed() over the EV range
+ * Frames are a uniform frame at every ADC code plus random synthetic scenes.
+ * Values are printed with enough digits to round-trip a float exactly.
+ *
+ * 'check' evaluates every variant registered below against the vectors and
+ * reports the max and mean error in stops, failing any variant whose max
+ * error is over the budget. An optimized rewrite (fixed point, LUT, fast
+ * log2) is registered as another variant next to the reference.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_shim.h"
+#include "led_control.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "scene_gen.h"
+
+#define GOLDEN_VERSION          1
+#define MODE_COUNT              (METERING_HIGHLIGHT + 1)
+
+// Time between pixels in the default firmware scan
+#define FIRMWARE_PIXEL_PERIOD_US    61000
+
+/* ---- Reference paths ---- */
+
+/**
+ * Float lux path of the firmware before the frame rewrite:
+ * convert_to_lux() per pixel, then calculate_ev_from_detailed()
+ */
+static float reference_ev(const uint16_t raw[FRAME_PIXELS], metering_mode_t mode) {
+    led_measurement_t measurements[5][4];
+
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        led_measurement_t *m = &measurements[i / FRAME_COLS][i % FRAME_COLS];
+        m->adc_value = raw[i];
+        m->voltage = get_voltage_from_adc(raw[i]);
+        m->lux = convert_to_lux(raw[i]);
+    }
+
+    return calculate_ev_from_detailed(measurements, mode);
+}
+
+/* ---- Variants under test ---- */
+
+static float lut_lux(int raw) {
+    return light_frame_lux_from_raw((uint16_t)raw);
+}
+
+static float frame_ev(const uint16_t raw[FRAME_PIXELS], metering_mode_t mode) {
+    light_frame_t frame;
+
+    light_frame_clear(&frame);
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        light_frame_set_raw(&frame, i, raw[i]);
+    }
+    return calculate_ev_from_frame(&frame, mode);
+}
+
+typedef struct {
+    const char *name;
+    float (*lux)(int raw);
+} lux_variant_t;
+
+typedef struct {
+    const char *name;
+    float (*ev)(const uint16_t raw[FRAME_PIXELS], metering_mode_t mode);
+} ev_variant_t;
+
+typedef struct {
+    const char *name;
+    float (*shutter)(float ev, int iso);
+} shutter_variant_t;
+
+static const lux_variant_t lux_variants[] = {
+    { "convert_to_lux", convert_to_lux },
+    { "light_frame_lut", lut_lux },
+};
+
+static const ev_variant_t ev_variants[] = {
+    { "ev_from_detailed", reference_ev },
+    { "ev_from_frame", frame_ev },
+};
+
+static const shutter_variant_t shutter_variants[] = {
+    { "calculate_shutter_speed", calculate_shutter_speed },
+};
+
+#define ARRAY_SIZE(a)   (int)(sizeof(a) / sizeof((a)[0]))
+
+/* ---- Error statistics ---- */
+
+typedef struct {
+    const char *name;
+    const char *quantity;
+    unsigned long count;
+    unsigned long mismatches;       // Inconsistent zero / non-finite results
+    double sum_abs;
+    double max_abs;
+} error_stats_t;
+
+/**
+ * Accumulate an error already expressed in stops
+ */
+static void add_stops(error_stats_t *s, double stops) {
+    if (!isfinite(stops)) {
+        s->mismatches++;
+        return;
+    }
+
+    double magnitude = fabs(stops);
+    s->count++;
+    s->sum_abs += magnitude;
+    if (magnitude > s->max_abs) {
+        s->max_abs = magnitude;
+    }
+}
+
+/**
+ * Accumulate the ratio of two positive quantities in stops
+ */
+static void add_ratio(error_stats_t *s, double value, double reference) {
+    if (value == reference) {
+        add_stops(s, 0.0);
+    } else if (value <= 0.0 || reference <= 0.0) {
+        s->mismatches++;
+    } else {
+        add_stops(s, log2(value / reference));
+    }
+}
+
+/* ---- Generate ---- */
+
+static void print_frame_vectors(const uint16_t raw[FRAME_PIXELS]) {
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        printf("E,%d,%.9g", mode, reference_ev(raw, (metering_mode_t)mode));
+        for (int i = 0; i < FRAME_PIXELS; i++) {
+            printf(",%u", raw[i]);
+        }
+        printf("\n");
+    }
+}
+
+static int generate(long frames, uint32_t seed) {
+    printf("GOLDEN,%d,%.9g,%ld,%lu\n", GOLDEN_VERSION, get_k_value(), frames, (unsigned long)seed);
+
+    for (int raw = 0; raw < ADC_CODE_COUNT; raw++) {
+        printf("L,%d,%.9g\n", raw, convert_to_lux(raw));
+    }
+
+    // Uniform frames cover every code in each metering mode
+    uint16_t raw[FRAME_PIXELS];
+    for (int code = 0; code < ADC_CODE_COUNT; code++) {
+        for (int i = 0; i < FRAME_PIXELS; i++) {
+            raw[i] = (uint16_t)code;
+        }
+        print_frame_vectors(raw);
+    }
+
+    scene_rng_t rng;
+    scene_t scene;
+    light_frame_t frame;
+    scene_adc_model_t adc = SCENE_ADC_MODEL_DEFAULT;
+
+    scene_rng_seed(&rng, seed);
+    for (long n = 0; n < frames; n++) {
+        scene_random(&scene, (scene_kind_t)(n % SCENE_KIND_COUNT), &rng);
+        int64_t start_us = (int64_t)(scene_rng_uniform(&rng) * 1e6f);
+        scene_sample_frame(&scene, &adc, &rng, start_us, FIRMWARE_PIXEL_PERIOD_US, &frame);
+        print_frame_vectors(frame.raw);
+    }
+
+    static const int isos[] = { 25, 100, 400, 1600, 6400 };
+    for (int step = -6 * 64; step <= 20 * 64; step++) {
+        float ev = step / 64.0f;
+        for (int i = 0; i < ARRAY_SIZE(isos); i++) {
+            printf("S,%.9g,%d,%.9g\n", ev, isos[i], calculate_shutter_speed(ev, isos[i]));
+        }
+    }
+
+    return 0;
+}
+
+/* ---- Check ---- */
+
+static bool parse_frame(const char *line, int *mode, float *ev, uint16_t raw[FRAME_PIXELS]) {
+    char *end;
+
+    *mode = (int)strtol(line + 2, &end, 10);
+    if (*end != ',' || *mode < 0 || *mode >= MODE_COUNT) {
+        return false;
+    }
+    *ev = strtof(end + 1, &end);
+
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        if (*end != ',') {
+            return false;
+        }
+        long value = strtol(end + 1, &end, 10);
+        if (value < 0 || value > ADC_MAX_CODE) {
+            return false;
+        }
+        raw[i] = (uint16_t)value;
+    }
+    return true;
+}
+
+static int check(FILE *in, double budget, bool json) {
+    error_stats_t lux_stats[ARRAY_SIZE(lux_variants)] = {0};
+    error_stats_t ev_stats[ARRAY_SIZE(ev_variants)] = {0};
+    error_stats_t shutter_stats[ARRAY_SIZE(shutter_variants)] = {0};
+    char *line = NULL;
+    size_t line_size = 0;
+    unsigned long line_number = 0;
+    unsigned long bad_lines = 0;
+    bool header = false;
+
+    for (int v = 0; v < ARRAY_SIZE(lux_variants); v++) {
+        lux_stats[v] = (error_stats_t){ .name = lux_variants[v].name, .quantity = "lux" };
+    }
+    for (int v = 0; v < ARRAY_SIZE(ev_variants); v++) {
+        ev_stats[v] = (error_stats_t){ .name = ev_variants[v].name, .quantity = "ev" };
+    }
+    for (int v = 0; v < ARRAY_SIZE(shutter_variants); v++) {
+        shutter_stats[v] = (error_stats_t){ .name = shutter_variants[v].name, .quantity = "shutter" };
+    }
+
+    while (getline(&line, &line_size, in) != -1) {
+        line_number++;
+
+        if (strncmp(line, "GOLDEN,", 7) == 0) {
+            int version;
+            float k;
+            if (sscanf(line + 7, "%d,%f", &version, &k) != 2 || version != GOLDEN_VERSION) {
+                fprintf(stderr, "Unsupported golden vector file (line %lu)\n", line_number);
+                free(line);
+                return 2;
+            }
+            set_k_value(k);
+            header = true;
+        } else if (strncmp(line, "L,", 2) == 0) {
+            int raw;
+            float lux;
+            if (sscanf(line + 2, "%d,%f", &raw, &lux) != 2 || raw < 0 || raw > ADC_MAX_CODE) {
+                bad_lines++;
+                continue;
+            }
+            for (int v = 0; v < ARRAY_SIZE(lux_variants); v++) {
+                add_ratio(&lux_stats[v], lux_variants[v].lux(raw), lux);
+            }
+        } else if (strncmp(line, "E,", 2) == 0) {
+            int mode;
+            float ev;
+            uint16_t raw[FRAME_PIXELS];
+            if (!parse_frame(line, &mode, &ev, raw)) {
+                bad_lines++;
+                continue;
+            }
+            // EV is already in stops
+            for (int v = 0; v < ARRAY_SIZE(ev_variants); v++) {
+                add_stops(&ev_stats[v], (double)ev_variants[v].ev(raw, (metering_mode_t)mode) - ev);
+            }
+        } else if (strncmp(line, "S,", 2) == 0) {
+            float ev, seconds;
+            int iso;
+            if (sscanf(line + 2, "%f,%d,%f", &ev, &iso, &seconds) != 3) {
+                bad_lines++;
+                continue;
+            }
+            for (int v = 0; v < ARRAY_SIZE(shutter_variants); v++) {
+                add_ratio(&shutter_stats[v], shutter_variants[v].shutter(ev, iso), seconds);
+            }
+        }
+    }
+    free(line);
+
+    if (!header) {
+        fprintf(stderr, "No GOLDEN header found\n");
+        return 2;
+    }
+
+    const error_stats_t *all[ARRAY_SIZE(lux_variants) + ARRAY_SIZE(ev_variants) + ARRAY_SIZE(shutter_variants)];
+    int total = 0;
+    for (int v = 0; v < ARRAY_SIZE(lux_variants); v++) {
+        all[total++] = &lux_stats[v];
+    }
+    for (int v = 0; v < ARRAY_SIZE(ev_variants); v++) {
+        all[total++] = &ev_stats[v];
+    }
+    for (int v = 0; v < ARRAY_SIZE(shutter_variants); v++) {
+        all[total++] = &shutter_stats[v];
+    }
+
+    int failures = 0;
+
+    if (!json) {
+        printf("%-24s %-8s %9s %12s %12s %10s %6s\n",
+               "variant", "output", "vectors", "max stops", "mean stops", "mismatch", "");
+    }
+
+    for (int i = 0; i < total; i++) {
+        const error_stats_t *s = all[i];
+        double mean = s->count ? s->sum_abs / s->count : 0.0;
+        bool pass = s->mismatches == 0 && s->max_abs <= budget;
+
+        if (!pass) {
+            failures++;
+        }
+
+        if (json) {
+            printf("{\"variant\":\"%s\",\"output\":\"%s\",\"vectors\":%lu,\"max_stops\":%.6g,"
+                   "\"mean_stops\":%.6g,\"mismatches\":%lu,\"budget_stops\":%.6g,\"pass\":%s}\n",
+                   s->name, s->quantity, s->count, s->max_abs, mean, s->mismatches, budget,
+                   pass ? "true" : "false");
+        } else {
+            printf("%-24s %-8s %9lu %12.3e %12.3e %10lu %6s\n",
+                   s->name, s->quantity, s->count, s->max_abs, mean, s->mismatches,
+                   pass ? "ok" : "FAIL");
+        }
+    }
+
+    if (bad_lines > 0) {
+        fprintf(stderr, "warning: %lu malformed vector lines skipped\n", bad_lines);
+    }
+    if (!json) {
+        printf("\nBudget: %.3g stops; %d of %d variants over budget\n", budget, failures, total);
+    }
+
+    return failures > 0 ? 1 : 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s generate [--frames <n>] [--seed <value>] > golden.txt\n"
+            "       %s check [--budget <stops>] [--json] [golden.txt]\n"
+            "  --frames <n>       Random scene frames besides the uniform ones (default: 10000)\n"
+            "  --seed <value>     Random seed (default: 1)\n"
+            "  --budget <stops>   Max error allowed per variant (default: 0.001)\n"
+            "  --json             Print JSON lines instead of a table\n",
+            prog, prog);
+}
+
+int main(int argc, char **argv) {
+    long frames = 10000;
+    uint32_t seed = 1;
+    double budget = 0.001;
+    bool json = false;
+    const char *path = NULL;
+
+    if (argc < 2 || (strcmp(argv[1], "generate") != 0 && strcmp(argv[1], "check") != 0)) {
+        usage(argv[0]);
+        return (argc >= 2 && strcmp(argv[1], "--help") == 0) ? 0 : 2;
+    }
+    bool generating = strcmp(argv[1], "generate") == 0;
+
+    for (int i = 2; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--frames") == 0 && value) {
+            frames = strtol(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            seed = (uint32_t)strtoul(value, NULL, 0);
+            i++;
+        } else if (strcmp(argv[i], "--budget") == 0 && value) {
+            budget = strtod(value, NULL);
+            i++;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    // Both sides use the shim's ideal calibration curve
+    host_shim_set_realtime(false);
+    host_shim_set_log_level(ESP_LOG_NONE);
+    led_control_init();
+    adc_reader_init();
+
+    if (generating) {
+        return generate(frames, seed);
+    }
+
+    FILE *in = stdin;
+    if (path != NULL && strcmp(path, "-") != 0) {
+        in = fopen(path, "r");
+        if (in == NULL) {
+            perror(path);
+            return 2;
+        }
+    }
+
+    int status = check(in, budget, json);
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    return status;
+}
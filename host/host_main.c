@@ -0,0 +1,309 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host entry point: runs the firmware's app_main against the simulated sensor
+ *
+ * The console is stdin/stdout, or with --pty a pseudo-terminal that the UI
+ * and host tools open like the device's serial port. --instances runs several
+ * emulated meters side by side, each on its own PTY.
+ */
+
+#define _GNU_SOURCE     // posix_openpt, cfmakeraw
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "host_shim.h"
+#include "sim_sensor.h"
+
+// Firmware entry point and measurement flag (main.c)
+void app_main(void);
+extern volatile bool start_measurement;
+
+// PTY console
+#define MAX_INSTANCES   64
+static char pty_link[256];
+static pid_t instance_pids[MAX_INSTANCES];
+static int instance_count = 0;
+
+/**
+ * Print command line usage
+ */
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --scene <name>       uniform, gradient, spot, hdr, backlight, specular or random\n"
+            "                       (default: uniform)\n"
+            "  --lux <value>        Base scene illuminance in lux, 0 for random (default: 1000)\n"
+            "  --noise <codes>      ADC noise sigma in codes (default: 1.5)\n"
+            "  --flicker <depth>    Mains flicker depth 0-1 at --flicker-hz (default: 0)\n"
+            "  --flicker-hz <hz>    Flicker frequency (default: 100)\n"
+            "  --seed <value>       Random seed for scenes and noise\n"
+            "  --fast               Run delays on the virtual clock without sleeping\n"
+            "  --log-level <level>  none, error, warn, info or debug (default: info)\n"
+            "  --pty <link>         Serve the console on a new PTY, symlinked at <link>\n"
+            "  --instances <n>      With --pty, run n meters on <link>0..<link>n-1 (seeds seed..seed+n-1)\n",
+            prog);
+}
+
+/**
+ * Check whether the console input has been fully consumed
+ */
+static bool input_exhausted(void) {
+    struct stat st;
+
+    if (fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode)) {
+        return lseek(STDIN_FILENO, 0, SEEK_CUR) >= st.st_size;
+    }
+
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    if (poll(&pfd, 1, 0) < 0) {
+        return false;
+    }
+    return (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) && !(pfd.revents & POLLIN);
+}
+
+/**
+ * Idle hook: exit once the input is closed and no measurement is pending
+ */
+static void exit_when_input_done(void) {
+    if (!start_measurement && input_exhausted()) {
+        fflush(stdout);
+        exit(0);
+    }
+}
+
+/**
+ * Remove the PTY symlink on exit
+ */
+static void remove_pty_link(void) {
+    if (pty_link[0] != '\0') {
+        unlink(pty_link);
+    }
+}
+
+/**
+ * Exit cleanly on SIGINT/SIGTERM so atexit handlers run
+ */
+static void exit_on_signal(int sig) {
+    (void)sig;
+    exit(0);
+}
+
+/**
+ * Forward SIGINT/SIGTERM to every instance
+ */
+static void stop_instances(int sig) {
+    for (int i = 0; i < instance_count; i++) {
+        kill(instance_pids[i], sig);
+    }
+}
+
+/**
+ * Create a PTY and move the console onto its master side
+ * The slave is put in raw mode, as a serial port would be, and published
+ * at the link path for clients to open
+ */
+static bool open_pty_console(const char *link) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("posix_openpt");
+        return false;
+    }
+
+    const char *slave_name = ptsname(master);
+    int slave = slave_name ? open(slave_name, O_RDWR | O_NOCTTY) : -1;
+    if (slave < 0) {
+        perror("ptsname");
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, B115200);
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+    close(slave);
+
+    // Replace a stale link from an earlier run, but never a regular file
+    struct stat st;
+    if (lstat(link, &st) == 0 && S_ISLNK(st.st_mode)) {
+        unlink(link);
+    }
+    if (symlink(slave_name, link) != 0) {
+        fprintf(stderr, "Cannot create %s: %s\n", link, strerror(errno));
+        return false;
+    }
+    snprintf(pty_link, sizeof(pty_link), "%s", link);
+    atexit(remove_pty_link);
+    signal(SIGINT, exit_on_signal);
+    signal(SIGTERM, exit_on_signal);
+
+    fprintf(stderr, "Console on %s (%s)\n", slave_name, link);
+
+    // While no client has the port open, output is discarded like a disconnected UART
+    signal(SIGPIPE, SIG_IGN);
+    if (dup2(master, STDIN_FILENO) < 0 || dup2(master, STDOUT_FILENO) < 0) {
+        perror("dup2");
+        return false;
+    }
+    close(master);
+    return true;
+}
+
+/**
+ * Fork one emulated meter per instance and wait for them
+ * Returns in each child with its instance number; the parent exits
+ */
+static int spawn_instances(int count) {
+    for (int i = 0; i < count; i++) {
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            perror("fork");
+            stop_instances(SIGTERM);
+            exit(1);
+        }
+        if (pid == 0) {
+            instance_count = 0;
+            return i;
+        }
+        instance_pids[instance_count++] = pid;
+    }
+
+    signal(SIGINT, stop_instances);
+    signal(SIGTERM, stop_instances);
+
+    int status = 0;
+    for (int i = 0; i < instance_count; i++) {
+        int child_status;
+        while (waitpid(instance_pids[i], &child_status, 0) < 0 && errno == EINTR) {
+        }
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != 0) {
+            status = 1;
+        }
+    }
+    exit(status);
+}
+
+/**
+ * Parse a log level name
+ */
+static bool parse_log_level(const char *name, esp_log_level_t *level) {
+    static const char *names[] = { "none", "error", "warn", "info", "debug", "verbose" };
+
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *level = (esp_log_level_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    sim_scene_t scene = SIM_SCENE_UNIFORM;
+    float lux = 1000.0f;
+    uint32_t seed = 1;
+    float flicker_depth = 0.0f;
+    float flicker_hz = 100.0f;
+    const char *pty = NULL;
+    int instances = 1;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--fast") == 0) {
+            host_shim_set_realtime(false);
+        } else if (strcmp(arg, "--scene") == 0 && value) {
+            if (!sim_sensor_scene_from_name(value, &scene)) {
+                fprintf(stderr, "Unknown scene: %s\n", value);
+                return 2;
+            }
+            i++;
+        } else if (strcmp(arg, "--lux") == 0 && value) {
+            lux = strtof(value, NULL);
+            i++;
+        } else if (strcmp(arg, "--noise") == 0 && value) {
+            sim_sensor_set_noise(strtof(value, NULL));
+            i++;
+        } else if (strcmp(arg, "--flicker") == 0 && value) {
+            flicker_depth = strtof(value, NULL);
+            i++;
+        } else if (strcmp(arg, "--flicker-hz") == 0 && value) {
+            flicker_hz = strtof(value, NULL);
+            i++;
+        } else if (strcmp(arg, "--seed") == 0 && value) {
+            seed = (uint32_t)strtoul(value, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--log-level") == 0 && value) {
+            esp_log_level_t level;
+            if (!parse_log_level(value, &level)) {
+                fprintf(stderr, "Unknown log level: %s\n", value);
+                return 2;
+            }
+            host_shim_set_log_level(level);
+            i++;
+        } else if (strcmp(arg, "--pty") == 0 && value) {
+            pty = value;
+            i++;
+        } else if (strcmp(arg, "--instances") == 0 && value) {
+            instances = (int)strtol(value, NULL, 10);
+            if (instances < 1 || instances > MAX_INSTANCES) {
+                fprintf(stderr, "Instances must be 1-%d\n", MAX_INSTANCES);
+                return 2;
+            }
+            i++;
+        } else {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    if (pty != NULL) {
+        char link[sizeof(pty_link)];
+
+        if (instances > 1) {
+            int instance = spawn_instances(instances);
+            snprintf(link, sizeof(link), "%s%d", pty, instance);
+            seed += instance;
+        } else {
+            snprintf(link, sizeof(link), "%s", pty);
+        }
+
+        if (!open_pty_console(link)) {
+            return 1;
+        }
+    } else if (instances > 1) {
+        fprintf(stderr, "--instances needs --pty\n");
+        return 2;
+    }
+
+    sim_sensor_init(seed);
+    sim_sensor_set_flicker(flicker_depth, flicker_hz);
+    sim_sensor_set_scene(scene, lux);
+
+    // The firmware polls the console one character at a time and expects
+    // EOF when nothing is waiting, as the ESP-IDF VFS console does; the shim's
+    // fgetc() polls stdin for that, so it stays unbuffered and blocking
+    setvbuf(stdin, NULL, _IONBF, 0);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    if (!isatty(STDIN_FILENO)) {
+        host_shim_set_idle_hook(exit_when_input_done);
+    }
+
+    app_main();
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*
+ * 4x5 Camera Light Meter
+ * Replays recorded frames through the firmware metering pipeline on the host
+ *
+ * Input is a console capture (or any file) containing the CAL line and REC
+ * records printed by the firmware after 'record on', in any 'config output'
+ * format (text, JSONL or binary), read through the meter_stream decoder;
+ * other lines are ignored.
+ * Each frame is metered with its recorded configuration and the EV is
+ * compared against the recorded result, then the corpus is replayed at
+ * full speed to measure throughput.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_shim.h"
+#include "led_control.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "frame_record.h"
+#include "meter_stream.h"
+
+#define READ_CHUNK  (1 << 16)
+
+static frame_record_t *records = NULL;
+static size_t record_count = 0;
+static size_t record_capacity = 0;
+static bool calibrated = false;
+static bool out_of_memory = false;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * Meter one recorded frame exactly as the firmware does after a measurement
+ */
+static float replay_record(const frame_record_t *record) {
+    light_frame_t frame;
+
+    light_frame_clear(&frame);
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        light_frame_set_raw(&frame, i, record->raw[i]);
+    }
+
+    set_k_value(record->k_value);
+    return calculate_ev_from_frame(&frame, record->mode);
+}
+
+/**
+ * Keep a decoded record for the replay passes
+ */
+static void on_record(const frame_record_t *record, frame_format_t format, void *ctx) {
+    (void)format;
+    (void)ctx;
+
+    if (out_of_memory) {
+        return;
+    }
+    if (record_count == record_capacity) {
+        size_t capacity = record_capacity ? record_capacity * 2 : 256;
+        frame_record_t *grown = realloc(records, capacity * sizeof(*records));
+        if (grown == NULL) {
+            perror("realloc");
+            out_of_memory = true;
+            return;
+        }
+        records = grown;
+        record_capacity = capacity;
+    }
+    records[record_count++] = *record;
+}
+
+/**
+ * Switch the ADC calibration to the capture's CAL line
+ */
+static void on_calibration(const int *mv_table, int codes, void *ctx) {
+    (void)ctx;
+
+    if (record_count > 0 && calibrated) {
+        fprintf(stderr, "warning: calibration changes mid-capture; using the last one\n");
+    }
+    host_shim_set_cali_table(mv_table, codes);
+    light_frame_init_lut(get_voltage_from_adc);
+    calibrated = true;
+}
+
+/**
+ * Load the CAL line and REC records from a capture
+ */
+static bool load_capture(FILE *in) {
+    static meter_stream_t stream;
+    static char buffer[READ_CHUNK];
+    size_t n;
+
+    meter_stream_init(&stream, on_record, NULL);
+    stream.on_calibration = on_calibration;
+
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0 && !out_of_memory) {
+        meter_stream_feed(&stream, buffer, n);
+    }
+    meter_stream_finish(&stream);
+
+    if (ferror(in)) {
+        perror("read");
+        return false;
+    }
+    if (out_of_memory) {
+        return false;
+    }
+
+    const meter_stream_stats_t *stats = &stream.stats;
+    if (stats->crc_errors > 0 || stats->malformed > 0) {
+        fprintf(stderr, "warning: skipped %llu records with a bad CRC and %llu malformed ones\n",
+                (unsigned long long)stats->crc_errors, (unsigned long long)stats->malformed);
+    }
+    if (!calibrated) {
+        fprintf(stderr, "warning: no CAL line found; using the simulated ADC calibration\n");
+    }
+    return true;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <capture file | ->\n"
+            "  --repeat <n>         Timed passes over the corpus (default: 100)\n"
+            "  --tolerance <ev>     Allowed EV difference per frame (default: 0)\n"
+            "  --json               Print the summary as a JSON object\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    long repeat = 100;
+    double tolerance = 0.0;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--repeat") == 0 && value) {
+            repeat = strtol(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--tolerance") == 0 && value) {
+            tolerance = strtod(value, NULL);
+            i++;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (path == NULL && (argv[i][0] != '-' || strcmp(argv[i], "-") == 0)) {
+            path = argv[i];
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    if (path == NULL) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FILE *in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        return 2;
+    }
+
+    host_shim_set_realtime(false);
+    host_shim_set_log_level(ESP_LOG_NONE);
+    led_control_init();
+    adc_reader_init();
+
+    bool loaded = load_capture(in);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (!loaded) {
+        return 2;
+    }
+    if (record_count == 0) {
+        fprintf(stderr, "No REC records found in %s\n", path);
+        return 2;
+    }
+
+    // Verification pass
+    size_t mismatches = 0;
+    double max_diff = 0.0;
+
+    for (size_t r = 0; r < record_count; r++) {
+        float ev = replay_record(&records[r]);
+        double diff = fabs((double)ev - (double)records[r].ev);
+
+        if (diff > max_diff) {
+            max_diff = diff;
+        }
+        if (diff > tolerance) {
+            mismatches++;
+            if (!json) {
+                printf("DIFF seq=%lu mode=%s recorded=%.6f replayed=%.6f delta=%+.6f\n",
+                       (unsigned long)records[r].seq, get_metering_mode_name(records[r].mode),
+                       records[r].ev, ev, ev - records[r].ev);
+            }
+        }
+    }
+
+    // Throughput passes
+    volatile float sink = 0.0f;
+    double start = now_ns();
+    for (long pass = 0; pass < repeat; pass++) {
+        for (size_t r = 0; r < record_count; r++) {
+            sink = replay_record(&records[r]);
+        }
+    }
+    double elapsed = now_ns() - start;
+    (void)sink;
+
+    double frames = (double)record_count * (repeat > 0 ? repeat : 0);
+    double ns_per_frame = frames > 0 ? elapsed / frames : 0.0;
+    double frames_per_s = elapsed > 0 ? frames * 1e9 / elapsed : 0.0;
+
+    if (json) {
+        printf("{\"records\":%zu,\"mismatches\":%zu,\"max_ev_diff\":%.6f,\"passes\":%ld,"
+               "\"ns_per_frame\":%.1f,\"frames_per_s\":%.0f}\n",
+               record_count, mismatches, max_diff, repeat, ns_per_frame, frames_per_s);
+    } else {
+        printf("Replayed %zu records: %zu mismatches (max EV diff %.6f, tolerance %.6f)\n",
+               record_count, mismatches, max_diff, tolerance);
+        printf("Throughput: %.0f frames/s (%.1f ns/frame over %ld passes)\n",
+               frames_per_s, ns_per_frame, repeat);
+    }
+
+    free(records);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,306 @@
+/*
+ * 4x5 Camera Light Meter
+ * Acquisition timing model and scan-strategy simulator
+ *
+ * Runs the firmware's own measure_frame() under each scan strategy against
+ * the simulated sensor. The virtual clock advances by every settle delay,
+ * busy-wait and ADC conversion the scan makes, so the frame time is what the
+ * strategy would take on the device; the input nodes follow an RC step
+ * response, so settling too briefly shows up as error. Scenes come from the
+ * synthetic generator, about a third of them under flickering light.
+ *
+ * Pixel errors are in stops against the true time-averaged illuminance, over
+ * pixels well inside the ADC range (codes 50 to 4000). EV errors pool every
+ * metering mode against the same mode applied to the ideal frame: the true
+ * illuminance as noise-free, clipped and quantized codes. Clipping and
+ * quantization are thus in the reference too, and EV error measures the scan
+ * strategy rather than the sensor's dynamic range. Frames whose saturated or
+ * low pixels differ from the ideal frame's meter different pixels, so their EV
+ * is not comparable: they are left out of the EV error and counted instead.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_shim.h"
+#include "led_control.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "scene_gen.h"
+#include "sim_sensor.h"
+
+#define MODE_COUNT              (METERING_HIGHLIGHT + 1)
+#define MAX_STRATEGIES          16
+
+// Pixels compared for pixel error: well above quantization, below clipping
+#define PIXEL_MIN_CODE          50
+#define PIXEL_MAX_CODE          4000
+
+// Results of one strategy
+typedef struct {
+    const char *name;
+    scan_config_t config;
+    double frame_us_sum;
+    double frame_us_max;
+    unsigned long frames;
+    double pixel_sq[2];             // Steady, flickering
+    unsigned long pixel_count[2];
+    double ev_sq;
+    double ev_max;
+    unsigned long ev_count;
+    unsigned long ev_skipped;       // Frames flagging other pixels than the ideal frame
+} strategy_result_t;
+
+static strategy_result_t results[MAX_STRATEGIES];
+static int result_count = 0;
+
+static void add_strategy(const char *name, const scan_config_t *config) {
+    if (result_count < MAX_STRATEGIES) {
+        results[result_count].name = name;
+        results[result_count].config = *config;
+        result_count++;
+    }
+}
+
+/**
+ * Ideal (noise-free) ADC code of an illuminance
+ */
+static double ideal_code(float lux) {
+    return lux * PHOTODIODE_SENSITIVITY * RLOAD_OHM / 3.3 * ADC_MAX_CODE;
+}
+
+/**
+ * Frame a perfect scan would read: the true illuminance, clipped and quantized
+ */
+static void ideal_frame(const scene_t *scene, light_frame_t *frame) {
+    light_frame_clear(frame);
+    for (int row = 0; row < FRAME_ROWS; row++) {
+        for (int col = 0; col < FRAME_COLS; col++) {
+            double code = round(ideal_code(scene->lux[row][col]));
+            code = code < 0.0 ? 0.0 : (code > ADC_MAX_CODE ? ADC_MAX_CODE : code);
+            light_frame_set_raw(frame, FRAME_INDEX(row, col), (uint16_t)code);
+        }
+    }
+}
+
+/**
+ * Scan a run of scenes with one strategy
+ */
+static void run_strategy(strategy_result_t *r, long scenes, uint32_t seed) {
+    scene_rng_t rng;
+    scene_t scene;
+    light_frame_t frame;
+    light_frame_t ideal;
+
+    // Same scenes, flicker phases and noise for every strategy
+    scene_rng_seed(&rng, seed);
+    sim_sensor_init(seed);
+    adc_reader_set_scan_config(&r->config);
+
+    for (long n = 0; n < scenes; n++) {
+        scene_random(&scene, (scene_kind_t)(n % SCENE_KIND_COUNT), &rng);
+        sim_sensor_load_scene(&scene);
+
+        // Start the scan at a random point of the flicker cycle
+        host_shim_advance_us((int64_t)(scene_rng_uniform(&rng) * 100000.0f));
+
+        int64_t start = host_shim_time_us();
+        measure_frame(&frame);
+        double frame_us = (double)(host_shim_time_us() - start);
+
+        r->frames++;
+        r->frame_us_sum += frame_us;
+        if (frame_us > r->frame_us_max) {
+            r->frame_us_max = frame_us;
+        }
+
+        int flicker = scene.params.flicker_depth > 0.0f ? 1 : 0;
+        for (int row = 0; row < FRAME_ROWS; row++) {
+            for (int col = 0; col < FRAME_COLS; col++) {
+                double truth = ideal_code(scene.lux[row][col]);
+                uint16_t raw = frame.raw[FRAME_INDEX(row, col)];
+
+                if (truth < PIXEL_MIN_CODE || truth > PIXEL_MAX_CODE || raw == 0) {
+                    continue;
+                }
+
+                double stops = log2(raw / truth);
+                r->pixel_sq[flicker] += stops * stops;
+                r->pixel_count[flicker]++;
+            }
+        }
+
+        // EV only compares when both frames meter the same pixels
+        ideal_frame(&scene, &ideal);
+        if (frame.saturated_mask != ideal.saturated_mask || frame.low_mask != ideal.low_mask) {
+            r->ev_skipped++;
+            continue;
+        }
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            double error = (double)calculate_ev_from_frame(&frame, (metering_mode_t)mode) -
+                           (double)calculate_ev_from_frame(&ideal, (metering_mode_t)mode);
+            r->ev_sq += error * error;
+            r->ev_count++;
+            if (fabs(error) > r->ev_max) {
+                r->ev_max = fabs(error);
+            }
+        }
+    }
+}
+
+static double rms(double sum_sq, unsigned long count) {
+    return count ? sqrt(sum_sq / count) : 0.0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --scenes <n>           Scenes per strategy (default: 2000)\n"
+            "  --strategy <name>      Only this firmware strategy (default: all)\n"
+            "  --tau <us>             Input settling time constant (default: %.0f)\n"
+            "  --conversion-us <us>   Duration of one ADC conversion (default: 20)\n"
+            "  --noise <codes>        ADC noise sigma in codes (default: 1.5)\n"
+            "  --seed <value>         Random seed (default: 1)\n"
+            "  --json                 Print JSON lines instead of a table\n"
+            "Custom strategy (added to the list when --order is given):\n"
+            "  --order <serial|column> --hold --mux-us <us> --enable-us <us>\n"
+            "  --gap-us <us> --oversample <n> --interval-us <us>\n",
+            prog, SIM_SENSOR_DEFAULT_TAU_US);
+}
+
+int main(int argc, char **argv) {
+    long scenes = 2000;
+    const char *only = NULL;
+    float tau_us = SIM_SENSOR_DEFAULT_TAU_US;
+    float noise = -1.0f;
+    uint32_t seed = 1;
+    bool json = false;
+    bool custom = false;
+    scan_config_t custom_config = SCAN_CONFIG_DEFAULT;
+
+    host_shim_set_realtime(false);
+    host_shim_set_log_level(ESP_LOG_NONE);
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--scenes") == 0 && value) {
+            scenes = strtol(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--strategy") == 0 && value) {
+            only = value;
+            i++;
+        } else if (strcmp(argv[i], "--tau") == 0 && value) {
+            tau_us = strtof(value, NULL);
+            i++;
+        } else if (strcmp(argv[i], "--conversion-us") == 0 && value) {
+            host_shim_set_adc_conversion_us(strtol(value, NULL, 10));
+            i++;
+        } else if (strcmp(argv[i], "--noise") == 0 && value) {
+            noise = strtof(value, NULL);
+            i++;
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            seed = (uint32_t)strtoul(value, NULL, 0);
+            i++;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--order") == 0 && value) {
+            custom = true;
+            custom_config.order = strcmp(value, "column") == 0 ? SCAN_ORDER_COLUMN_PARALLEL
+                                                               : SCAN_ORDER_SERIAL;
+            i++;
+        } else if (strcmp(argv[i], "--hold") == 0) {
+            custom_config.hold_enable = true;
+        } else if (strcmp(argv[i], "--mux-us") == 0 && value) {
+            custom_config.mux_settle_us = strtoul(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--enable-us") == 0 && value) {
+            custom_config.enable_settle_us = strtoul(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--gap-us") == 0 && value) {
+            custom_config.pixel_gap_us = strtoul(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--oversample") == 0 && value) {
+            custom_config.oversample = (uint8_t)strtoul(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--interval-us") == 0 && value) {
+            custom_config.oversample_interval_us = strtoul(value, NULL, 10);
+            i++;
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    int preset_count;
+    const scan_preset_t *presets = adc_reader_scan_presets(&preset_count);
+
+    for (int i = 0; i < preset_count; i++) {
+        if (only == NULL || strcmp(only, presets[i].name) == 0) {
+            add_strategy(presets[i].name, &presets[i].config);
+        }
+    }
+    if (custom) {
+        add_strategy("custom", &custom_config);
+    }
+    if (result_count == 0) {
+        fprintf(stderr, "Unknown scan strategy: %s\n", only);
+        return 2;
+    }
+
+    led_control_init();
+    adc_reader_init();
+    sim_sensor_set_settle_tau(tau_us);
+    if (noise >= 0.0f) {
+        sim_sensor_set_noise(noise);
+    }
+
+    if (!json) {
+        printf("%-16s %10s %8s %12s %12s %9s %9s %9s\n",
+               "strategy", "frame ms", "fps", "pix steady", "pix flicker", "EV rms", "EV max", "flags %");
+    }
+
+    for (int i = 0; i < result_count; i++) {
+        strategy_result_t *r = &results[i];
+        run_strategy(r, scenes, seed);
+
+        double frame_ms = r->frame_us_sum / r->frames / 1000.0;
+        double fps = frame_ms > 0 ? 1000.0 / frame_ms : 0.0;
+        double steady = rms(r->pixel_sq[0], r->pixel_count[0]);
+        double flicker = rms(r->pixel_sq[1], r->pixel_count[1]);
+        double ev_rms = rms(r->ev_sq, r->ev_count);
+        double flagged = 100.0 * r->ev_skipped / r->frames;
+
+        if (json) {
+            printf("{\"strategy\":\"%s\",\"order\":\"%s\",\"hold_enable\":%s,\"mux_settle_us\":%lu,"
+                   "\"enable_settle_us\":%lu,\"pixel_gap_us\":%lu,\"oversample\":%u,"
+                   "\"oversample_interval_us\":%lu,\"tau_us\":%.1f,\"frames\":%lu,"
+                   "\"frame_ms\":%.3f,\"frame_ms_max\":%.3f,\"fps\":%.2f,"
+                   "\"pixel_rms_stops_steady\":%.4f,\"pixel_rms_stops_flicker\":%.4f,"
+                   "\"ev_rms\":%.4f,\"ev_max_abs\":%.4f,\"ev_frames_skipped\":%lu}\n",
+                   r->name, r->config.order == SCAN_ORDER_COLUMN_PARALLEL ? "column" : "serial",
+                   r->config.hold_enable ? "true" : "false",
+                   (unsigned long)r->config.mux_settle_us, (unsigned long)r->config.enable_settle_us,
+                   (unsigned long)r->config.pixel_gap_us, (unsigned)r->config.oversample,
+                   (unsigned long)r->config.oversample_interval_us, tau_us, r->frames,
+                   frame_ms, r->frame_us_max / 1000.0, fps, steady, flicker, ev_rms, r->ev_max,
+                   r->ev_skipped);
+        } else {
+            printf("%-16s %10.2f %8.1f %12.4f %12.4f %9.3f %9.3f %9.1f\n",
+                   r->name, frame_ms, fps, steady, flicker, ev_rms, r->ev_max, flagged);
+        }
+    }
+
+    if (!json) {
+        printf("\nPixel errors are rms stops (codes %d-%d); EV errors pool all metering modes against\n"
+               "the ideal clipped and quantized frame, over frames flagging the same saturated and\n"
+               "low pixels as it (flags %% is the share left out). tau = %.1f us\n",
+               PIXEL_MIN_CODE, PIXEL_MAX_CODE, tau_us);
+    }
+
+    return 0;
+}
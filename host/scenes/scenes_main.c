@@ -0,0 +1,191 @@
+/*
+ * 4x5 Camera Light Meter
+ * Metering accuracy and throughput over synthetic scenes
+ *
+ * Renders random scenes of each family, samples them as the ADC would and
+ * meters the frame in every mode with the firmware pipeline. The reference
+ * EV applies the same mode weighting to the true (noise-free, unclipped,
+ * flicker-averaged) illuminance, so the error is what the sensor, ADC and
+ * pixel rejection add. Errors are reported in stops.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host_shim.h"
+#include "led_control.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "scene_gen.h"
+
+#define MODE_COUNT              (METERING_HIGHLIGHT + 1)
+
+// Time between pixels in the firmware scan (mux settle + enable settle + inter-pixel delay)
+#define FIRMWARE_PIXEL_PERIOD_US    60000
+
+// Error accumulator for one scene family and metering mode
+typedef struct {
+    unsigned long count;
+    double sum;
+    double sum_abs;
+    double sum_sq;
+    double max_abs;
+    unsigned long within_third;     // |error| <= 1/3 stop
+} error_stats_t;
+
+static error_stats_t stats[SCENE_KIND_COUNT][MODE_COUNT];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void add_error(error_stats_t *s, double error) {
+    double magnitude = fabs(error);
+
+    s->count++;
+    s->sum += error;
+    s->sum_abs += magnitude;
+    s->sum_sq += error * error;
+    if (magnitude > s->max_abs) {
+        s->max_abs = magnitude;
+    }
+    if (magnitude <= 1.0 / 3.0) {
+        s->within_third++;
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --scenes <n>         Scenes per family (default: 10000)\n"
+            "  --kind <name>        Only this family: flat, hdr, backlight or specular\n"
+            "  --noise <codes>      ADC noise sigma in codes (default: 1.5)\n"
+            "  --pixel-period <us>  Time between pixel samples (default: %d)\n"
+            "  --seed <value>       Random seed (default: 1)\n"
+            "  --json               Print JSON lines instead of a table\n",
+            prog, FIRMWARE_PIXEL_PERIOD_US);
+}
+
+int main(int argc, char **argv) {
+    long scenes_per_kind = 10000;
+    int only_kind = -1;
+    long pixel_period_us = FIRMWARE_PIXEL_PERIOD_US;
+    uint32_t seed = 1;
+    bool json = false;
+    scene_adc_model_t adc = SCENE_ADC_MODEL_DEFAULT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(argv[i], "--scenes") == 0 && value) {
+            scenes_per_kind = strtol(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--kind") == 0 && value) {
+            scene_kind_t kind;
+            if (!scene_kind_from_name(value, &kind)) {
+                fprintf(stderr, "Unknown scene family: %s\n", value);
+                return 2;
+            }
+            only_kind = kind;
+            i++;
+        } else if (strcmp(argv[i], "--noise") == 0 && value) {
+            adc.noise_sigma = strtof(value, NULL);
+            i++;
+        } else if (strcmp(argv[i], "--pixel-period") == 0 && value) {
+            pixel_period_us = strtol(value, NULL, 10);
+            i++;
+        } else if (strcmp(argv[i], "--seed") == 0 && value) {
+            seed = (uint32_t)strtoul(value, NULL, 0);
+            i++;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    host_shim_set_realtime(false);
+    host_shim_set_log_level(ESP_LOG_NONE);
+    led_control_init();
+    adc_reader_init();
+
+    scene_rng_t rng;
+    scene_t scene;
+    light_frame_t frame;
+    unsigned long total_scenes = 0;
+
+    scene_rng_seed(&rng, seed);
+    double start = now_ns();
+
+    for (int kind = 0; kind < SCENE_KIND_COUNT; kind++) {
+        if (only_kind >= 0 && kind != only_kind) {
+            continue;
+        }
+
+        for (long n = 0; n < scenes_per_kind; n++) {
+            scene_random(&scene, (scene_kind_t)kind, &rng);
+
+            // Start each scan at a random point of the flicker cycle
+            int64_t start_us = (int64_t)(scene_rng_uniform(&rng) * 1e6f);
+            scene_sample_frame(&scene, &adc, &rng, start_us, pixel_period_us, &frame);
+
+            for (int mode = 0; mode < MODE_COUNT; mode++) {
+                float truth = calculate_ev(scene.lux, (metering_mode_t)mode);
+                float measured = calculate_ev_from_frame(&frame, (metering_mode_t)mode);
+                add_error(&stats[kind][mode], (double)measured - (double)truth);
+            }
+            total_scenes++;
+        }
+    }
+
+    double elapsed = now_ns() - start;
+    double scenes_per_s = elapsed > 0 ? total_scenes * 1e9 / elapsed : 0.0;
+
+    if (!json) {
+        printf("%-10s %-16s %10s %10s %10s %10s %9s\n",
+               "family", "mode", "bias", "mean|err|", "rms", "max|err|", "<=1/3 EV");
+    }
+
+    for (int kind = 0; kind < SCENE_KIND_COUNT; kind++) {
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            const error_stats_t *s = &stats[kind][mode];
+
+            if (s->count == 0) {
+                continue;
+            }
+
+            double bias = s->sum / s->count;
+            double mean_abs = s->sum_abs / s->count;
+            double rms = sqrt(s->sum_sq / s->count);
+            double within = 100.0 * s->within_third / s->count;
+
+            if (json) {
+                printf("{\"family\":\"%s\",\"mode\":\"%s\",\"scenes\":%lu,\"bias\":%.4f,"
+                       "\"mean_abs\":%.4f,\"rms\":%.4f,\"max_abs\":%.4f,\"within_third_pct\":%.2f}\n",
+                       scene_kind_name((scene_kind_t)kind), get_metering_mode_name((metering_mode_t)mode),
+                       s->count, bias, mean_abs, rms, s->max_abs, within);
+            } else {
+                printf("%-10s %-16s %+10.3f %10.3f %10.3f %10.3f %8.1f%%\n",
+                       scene_kind_name((scene_kind_t)kind), get_metering_mode_name((metering_mode_t)mode),
+                       bias, mean_abs, rms, s->max_abs, within);
+            }
+        }
+    }
+
+    if (json) {
+        printf("{\"scenes\":%lu,\"scenes_per_s\":%.0f}\n", total_scenes, scenes_per_s);
+    } else {
+        printf("\n%lu scenes in %.2f s (%.0f scenes/s, all modes metered per scene)\n",
+               total_scenes, elapsed / 1e9, scenes_per_s);
+    }
+
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * ESP-IDF Shim for 4x5 Camera Light Meter host build
+ * Implements the driver, logging and FreeRTOS calls used by the firmware
+ * on top of a virtual clock and the simulated sensor
+ */
+
+#include "host_shim.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "led_control.h"
+#include "sim_sensor.h"
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// CPU clock reported to the firmware (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ)
+#define CPU_FREQ_MHZ        160
+
+// Approximate duration of one oneshot conversion on the ESP32-C3
+#define ADC_CONVERSION_US   20
+
+static int64_t adc_conversion_us = ADC_CONVERSION_US;
+
+// Virtual clock, advanced by delays and conversions
+static int64_t virtual_time_us = 0;
+static bool realtime = true;
+static void (*idle_hook)(void) = NULL;
+
+// Logging
+#define MAX_TAG_LEVELS  16
+static esp_log_level_t default_level = ESP_LOG_INFO;
+static struct {
+    const char *tag;
+    esp_log_level_t level;
+} tag_levels[MAX_TAG_LEVELS];
+static int tag_level_count = 0;
+
+// Latched GPIO output levels
+static uint32_t gpio_levels[GPIO_PIN_COUNT];
+
+// Calibration table loaded from a recording (NULL: ideal linear curve)
+static const int *cali_table = NULL;
+static int cali_codes = 0;
+
+// Handles only need to be non-NULL
+static int adc_unit_token;
+static int adc_cali_token;
+
+/* ---- Host control ---- */
+
+void host_shim_set_realtime(bool enable) {
+    realtime = enable;
+}
+
+void host_shim_set_log_level(esp_log_level_t level) {
+    default_level = level;
+}
+
+void host_shim_set_idle_hook(void (*hook)(void)) {
+    idle_hook = hook;
+}
+
+int64_t host_shim_time_us(void) {
+    return virtual_time_us;
+}
+
+void host_shim_advance_us(int64_t us) {
+    virtual_time_us += us;
+
+    if (realtime && us > 0) {
+        struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void host_shim_set_adc_conversion_us(int64_t us) {
+    adc_conversion_us = us;
+}
+
+void host_shim_set_cali_table(const int *mv_table, int codes) {
+    cali_table = mv_table;
+    cali_codes = codes;
+}
+
+/* ---- Logging ---- */
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            tag_levels[i].level = level;
+            return;
+        }
+    }
+
+    if (tag_level_count < MAX_TAG_LEVELS) {
+        tag_levels[tag_level_count].tag = tag;
+        tag_levels[tag_level_count].level = level;
+        tag_level_count++;
+    }
+}
+
+esp_log_level_t esp_log_level_get(const char *tag) {
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0) {
+            return tag_levels[i].level;
+        }
+    }
+
+    return default_level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+    esp_log_level_t limit = default_level;
+
+    for (int i = 0; i < tag_level_count; i++) {
+        if (strcmp(tag_levels[i].tag, tag) == 0 && tag_levels[i].level < limit) {
+            limit = tag_levels[i].level;
+        }
+    }
+
+    if (level > limit) {
+        return;
+    }
+
+    static const char letters[] = "NEWIDV";
+    va_list args;
+
+    fprintf(stderr, "%c (%lld) %s: ", letters[level], (long long)(virtual_time_us / 1000), tag);
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+/* ---- System ---- */
+
+void esp_restart(void) {
+    fflush(stdout);
+    fprintf(stderr, "esp_restart() called - exiting host build\n");
+    exit(0);
+}
+
+/* ---- Console ---- */
+
+/**
+ * fgetc() for the firmware: EOF instead of blocking when stdin has nothing waiting
+ * (stdin is unbuffered, so there is no stdio buffer that poll() would miss)
+ */
+int host_console_fgetc(FILE *stream) {
+    if (stream == stdin) {
+        struct pollfd pfd = { .fd = fileno(stdin), .events = POLLIN };
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLIN | POLLHUP))) {
+            return EOF;
+        }
+    }
+    return fgetc(stream);
+}
+
+/* ---- Timer ---- */
+
+int64_t esp_timer_get_time(void) {
+    return virtual_time_us;
+}
+
+/* ---- FreeRTOS ---- */
+
+void vTaskDelay(const TickType_t ticks) {
+    if (idle_hook != NULL) {
+        idle_hook();
+    }
+
+    host_shim_advance_us((int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    host_shim_advance_us(us);
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void) {
+    return CPU_FREQ_MHZ;
+}
+
+/* ---- CPU ---- */
+
+/**
+ * Host time in cycles of the device clock, so benchmarks report comparable units
+ */
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (esp_cpu_cycle_count_t)(((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec) * CPU_FREQ_MHZ / 1000);
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(virtual_time_us / (portTICK_PERIOD_MS * 1000));
+}
+
+/* ---- GPIO ---- */
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    if (config == NULL || (config->pin_bit_mask >> GPIO_PIN_COUNT) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num < 0 || gpio_num >= GPIO_PIN_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t previous = gpio_levels[gpio_num];
+    gpio_levels[gpio_num] = level ? 1 : 0;
+
+    // Switching the multiplexers starts the analog settling of the inputs
+    if (gpio_levels[gpio_num] != previous &&
+        (gpio_num == MULTIPLEX_0_PIN || gpio_num == MULTIPLEX_1_PIN || gpio_num == ENABLE_PIN)) {
+        int col = gpio_levels[MULTIPLEX_0_PIN] | (gpio_levels[MULTIPLEX_1_PIN] << 1);
+        sim_sensor_route(col, gpio_levels[ENABLE_PIN] == 0);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num < 0 || gpio_num >= GPIO_PIN_COUNT) {
+        return 0;
+    }
+    return (int)gpio_levels[gpio_num];
+}
+
+/* ---- ADC ---- */
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit) {
+    if (init_config == NULL || ret_unit == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *ret_unit = (adc_oneshot_unit_handle_t)&adc_unit_token;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel, const adc_oneshot_chan_cfg_t *config) {
+    if (handle == NULL || config == NULL || channel > ADC_CHANNEL_4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Serve a conversion from the simulated sensor
+ * The channel selects the row; the multiplexer routing was handed to the
+ * sensor model as the pins switched. The input is sampled at the end of the
+ * conversion time.
+ */
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw) {
+    if (handle == NULL || out_raw == NULL || chan > ADC_CHANNEL_4) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_shim_advance_us(adc_conversion_us);
+
+    *out_raw = sim_sensor_sample((int)chan);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t *config, adc_cali_handle_t *ret_handle) {
+    if (config == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *ret_handle = (adc_cali_handle_t)&adc_cali_token;
+    return ESP_OK;
+}
+
+/**
+ * Calibration from a loaded table, else ideal linear over the 12 dB range (0-3.3V)
+ */
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage) {
+    if (handle == NULL || voltage == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (cali_table != NULL && raw >= 0 && raw < cali_codes) {
+        *voltage = cali_table[raw];
+    } else {
+        *voltage = (int)(((int64_t)raw * 3300 + 2047) / 4095);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,10 @@
+/*
+ * ESP-IDF shim: UART driver (the console is stdin/stdout on the host)
+ */
+
+#ifndef DRIVER_UART_H
+#define DRIVER_UART_H
+
+#include "esp_err.h"
+
+#endif // DRIVER_UART_H
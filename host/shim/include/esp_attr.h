@@ -0,0 +1,12 @@
+/*
+ * ESP-IDF shim: memory placement attributes (no-ops on the host)
+ */
+
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DRAM_STR(str) (str)
+
+#endif // ESP_ATTR_H
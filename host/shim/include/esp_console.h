@@ -0,0 +1,18 @@
+/*
+ * ESP-IDF shim: console
+ * The firmware reads the console through stdio, which the host maps to stdin/stdout
+ */
+
+#ifndef ESP_CONSOLE_H
+#define ESP_CONSOLE_H
+
+#include <stdio.h>
+#include "esp_err.h"
+
+// The device's VFS console returns EOF from fgetc(stdin) when nothing is
+// waiting. The host keeps stdin blocking, since it may share its file
+// description with stdout (a terminal, or the PTY master), and polls it instead.
+int host_console_fgetc(FILE *stream);
+#define fgetc(stream) host_console_fgetc(stream)
+
+#endif // ESP_CONSOLE_H
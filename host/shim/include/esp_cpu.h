@@ -0,0 +1,14 @@
+/*
+ * ESP-IDF shim: CPU cycle counter (host monotonic clock scaled to the C3 clock)
+ */
+
+#ifndef ESP_CPU_H
+#define ESP_CPU_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+#endif // ESP_CPU_H
@@ -0,0 +1,15 @@
+/*
+ * ESP-IDF shim: memory region checks (nothing on the host is in IRAM)
+ */
+
+#ifndef ESP_MEMORY_UTILS_H
+#define ESP_MEMORY_UTILS_H
+
+#include <stdbool.h>
+
+static inline bool esp_ptr_in_iram(const void *p) {
+    (void)p;
+    return false;
+}
+
+#endif // ESP_MEMORY_UTILS_H
@@ -0,0 +1,13 @@
+/*
+ * ESP-IDF shim: ROM busy-wait delay (advances the virtual clock) and CPU clock
+ */
+
+#ifndef ESP_ROM_SYS_H
+#define ESP_ROM_SYS_H
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
+uint32_t esp_rom_get_cpu_ticks_per_us(void);
+
+#endif // ESP_ROM_SYS_H
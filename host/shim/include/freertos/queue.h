@@ -0,0 +1,12 @@
+/*
+ * ESP-IDF shim: FreeRTOS queues (types only, the firmware does not use queues yet)
+ */
+
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct queue_definition *QueueHandle_t;
+
+#endif // QUEUE_H
@@ -0,0 +1,14 @@
+/*
+ * ESP-IDF shim: FreeRTOS tasks
+ * Delays advance the host's virtual clock (and sleep when running in real time)
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(const TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+#endif // TASK_H
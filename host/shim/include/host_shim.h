@@ -0,0 +1,22 @@
+/*
+ * Host Shim Control for 4x5 Camera Light Meter
+ * Settings of the ESP-IDF shim used by the Linux host build
+ */
+
+#ifndef HOST_SHIM_H
+#define HOST_SHIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_log.h"
+
+// Function prototypes
+void host_shim_set_realtime(bool realtime);
+void host_shim_set_log_level(esp_log_level_t level);
+void host_shim_set_idle_hook(void (*hook)(void));
+int64_t host_shim_time_us(void);
+void host_shim_advance_us(int64_t us);
+void host_shim_set_adc_conversion_us(int64_t us);
+void host_shim_set_cali_table(const int *mv_table, int codes);
+
+#endif // HOST_SHIM_H
@@ -0,0 +1,210 @@
+/*
+ * Synthetic Scene Generator for 4x5 Camera Light Meter host tools
+ * Implementation file
+ */
+
+#include "scene_gen.h"
+#include <math.h>
+#include <strings.h>
+
+#define TWO_PI  6.2831853f
+
+static const char *kind_names[SCENE_KIND_COUNT] = {
+    "flat", "hdr", "backlight", "specular"
+};
+
+/* ---- Random numbers ---- */
+
+void scene_rng_seed(scene_rng_t *rng, uint32_t seed) {
+    rng->state = seed ? seed : 0x2545F491u;
+}
+
+uint32_t scene_rng_next(scene_rng_t *rng) {
+    uint32_t x = rng->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rng->state = x;
+    return x;
+}
+
+/**
+ * Uniform random value in [0, 1)
+ */
+float scene_rng_uniform(scene_rng_t *rng) {
+    return (scene_rng_next(rng) >> 8) * (1.0f / 16777216.0f);
+}
+
+/**
+ * Normal random value (Box-Muller)
+ */
+float scene_rng_gaussian(scene_rng_t *rng) {
+    float u1 = scene_rng_uniform(rng) + 1e-7f;
+    float u2 = scene_rng_uniform(rng);
+    return sqrtf(-2.0f * logf(u1)) * cosf(TWO_PI * u2);
+}
+
+/* ---- Scene kinds ---- */
+
+const char *scene_kind_name(scene_kind_t kind) {
+    return (kind >= 0 && kind < SCENE_KIND_COUNT) ? kind_names[kind] : "unknown";
+}
+
+bool scene_kind_from_name(const char *name, scene_kind_t *kind) {
+    for (int i = 0; i < SCENE_KIND_COUNT; i++) {
+        if (strcasecmp(name, kind_names[i]) == 0) {
+            *kind = (scene_kind_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ---- Rendering ---- */
+
+/**
+ * Offset in stops of a gradient at a pixel
+ * The frame spans roughly +/-2.5 pixels along any direction, so the
+ * gradient covers range_stops from one edge to the other
+ */
+static float gradient_stops(const scene_params_t *params, int row, int col) {
+    float x = col - (FRAME_COLS - 1) * 0.5f;
+    float y = row - (FRAME_ROWS - 1) * 0.5f;
+    float d = x * cosf(params->angle_rad) + y * sinf(params->angle_rad);
+    return params->range_stops * d / 5.0f;
+}
+
+/**
+ * Render a scene from explicit parameters
+ * The generator is used for hotspot placement and the flicker phase
+ */
+void scene_render(scene_t *scene, const scene_params_t *params, scene_rng_t *rng) {
+    scene->params = *params;
+    scene->flicker_phase = scene_rng_uniform(rng) * TWO_PI;
+
+    for (int row = 0; row < FRAME_ROWS; row++) {
+        for (int col = 0; col < FRAME_COLS; col++) {
+            float lux = params->key_lux;
+
+            switch (params->kind) {
+                case SCENE_HDR_GRADIENT:
+                    lux = params->key_lux * exp2f(gradient_stops(params, row, col));
+                    break;
+                case SCENE_BACKLIGHT:
+                    // Subject covers the lower centre (rows 3-5, columns 2-3)
+                    if (row >= 2 && col >= 1 && col <= 2) {
+                        lux = params->key_lux * exp2f(-params->range_stops);
+                    }
+                    break;
+                case SCENE_SPECULAR:
+                    lux = params->key_lux * exp2f(0.5f * gradient_stops(params, row, col));
+                    break;
+                default:
+                    break;
+            }
+
+            scene->lux[row][col] = lux;
+        }
+    }
+
+    // Hotspots are smaller than a pixel: each lifts a fraction of its pixel's area
+    for (int h = 0; h < params->hotspot_count; h++) {
+        int row = (int)(scene_rng_uniform(rng) * FRAME_ROWS);
+        int col = (int)(scene_rng_uniform(rng) * FRAME_COLS);
+        float area = 0.05f + 0.45f * scene_rng_uniform(rng);
+
+        scene->lux[row][col] *= 1.0f + area * (exp2f(params->hotspot_stops) - 1.0f);
+    }
+}
+
+/**
+ * Render a random scene of the given family across the metering range
+ */
+void scene_random(scene_t *scene, scene_kind_t kind, scene_rng_t *rng) {
+    scene_params_t params = {
+        .kind = kind,
+        .key_lux = 20.0f * exp2f(scene_rng_uniform(rng) * 12.0f),   // 20 lux to 80k lux
+        .range_stops = 0.0f,
+        .angle_rad = scene_rng_uniform(rng) * TWO_PI,
+        .hotspot_count = 0,
+        .hotspot_stops = 0.0f,
+        .flicker_depth = 0.0f,
+        .flicker_hz = 100.0f,
+    };
+
+    switch (kind) {
+        case SCENE_HDR_GRADIENT:
+            params.range_stops = 1.0f + 7.0f * scene_rng_uniform(rng);
+            break;
+        case SCENE_BACKLIGHT:
+            params.key_lux *= 4.0f;
+            params.range_stops = 2.0f + 4.0f * scene_rng_uniform(rng);
+            break;
+        case SCENE_SPECULAR:
+            params.range_stops = 1.0f + 3.0f * scene_rng_uniform(rng);
+            params.hotspot_count = 1 + (int)(scene_rng_uniform(rng) * 3.0f);
+            params.hotspot_stops = 2.0f + 4.0f * scene_rng_uniform(rng);
+            break;
+        default:
+            break;
+    }
+
+    // About a third of scenes are lit by flickering mains lighting
+    if (scene_rng_uniform(rng) < 0.33f) {
+        params.flicker_depth = 0.1f + 0.8f * scene_rng_uniform(rng);
+        params.flicker_hz = (scene_rng_uniform(rng) < 0.5f) ? 100.0f : 120.0f;
+    }
+
+    scene_render(scene, &params, rng);
+}
+
+/* ---- Sampling ---- */
+
+/**
+ * Instantaneous illuminance of a 0-indexed pixel, including flicker
+ */
+float scene_lux_at(const scene_t *scene, int row, int col, int64_t time_us) {
+    float lux = scene->lux[row][col];
+
+    if (scene->params.flicker_depth > 0.0f) {
+        float cycles = (float)fmod((double)time_us * scene->params.flicker_hz * 1e-6, 1.0);
+        lux *= 1.0f + scene->params.flicker_depth * cosf(TWO_PI * cycles + scene->flicker_phase);
+    }
+
+    return lux;
+}
+
+/**
+ * Sample an illuminance as an ADC code
+ * Viout = 0.0057e-6 x lux x R1 over a 3.3V / 12-bit range, plus ADC noise
+ */
+uint16_t scene_adc_code(float lux, const scene_adc_model_t *adc, scene_rng_t *rng) {
+    float voltage = lux * PHOTODIODE_SENSITIVITY * RLOAD_OHM;
+    float code = voltage / 3.3f * ADC_MAX_CODE + adc->offset_codes;
+
+    if (adc->noise_sigma > 0.0f) {
+        code += adc->noise_sigma * scene_rng_gaussian(rng);
+    }
+
+    long raw = lroundf(code);
+    if (raw < adc->dead_zone_codes) {
+        return 0;
+    }
+    return (raw > ADC_MAX_CODE) ? ADC_MAX_CODE : (uint16_t)raw;
+}
+
+/**
+ * Sample a full frame in scan order, one pixel every pixel_period_us
+ */
+void scene_sample_frame(const scene_t *scene, const scene_adc_model_t *adc, scene_rng_t *rng,
+                        int64_t start_us, int64_t pixel_period_us, light_frame_t *frame) {
+    light_frame_clear(frame);
+
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        int row = i / FRAME_COLS;
+        int col = i % FRAME_COLS;
+        float lux = scene_lux_at(scene, row, col, start_us + i * pixel_period_us);
+
+        light_frame_set_raw(frame, i, scene_adc_code(lux, adc, rng));
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Synthetic Scene Generator for 4x5 Camera Light Meter host tools
+ * Renders HDR scenes onto the 5x4 sensor footprint and samples them as ADC codes
+ *
+ * A scene holds the true (time-averaged) illuminance of every pixel. Sampling
+ * applies flicker at the sample time, then the photodiode/load-resistor
+ * transfer, ADC noise, quantization and clipping of the ESP32-C3 ADC.
+ */
+
+#ifndef SCENE_GEN_H
+#define SCENE_GEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "light_frame.h"
+
+// Scene families
+typedef enum {
+    SCENE_FLAT,             // Uniform illuminance
+    SCENE_HDR_GRADIENT,     // Linear-in-stops gradient across the frame at a random angle
+    SCENE_BACKLIGHT,        // Dark subject in the lower centre against a bright background
+    SCENE_SPECULAR,         // Gradient base with small, very bright hotspots
+    SCENE_KIND_COUNT
+} scene_kind_t;
+
+// Parameters a scene is rendered from
+typedef struct {
+    scene_kind_t kind;
+    float key_lux;          // Illuminance at the frame centre (or background for backlight)
+    float range_stops;      // Gradient span / subject-to-background contrast in stops
+    float angle_rad;        // Gradient direction
+    int hotspot_count;      // Specular hotspots
+    float hotspot_stops;    // Hotspot brightness above the local level
+    float flicker_depth;    // Peak modulation as a fraction of the mean (0 = steady light)
+    float flicker_hz;       // Modulation frequency (100 or 120 Hz for mains lighting)
+} scene_params_t;
+
+// A rendered scene
+typedef struct {
+    scene_params_t params;
+    float lux[FRAME_ROWS][FRAME_COLS];      // True time-averaged illuminance
+    float flicker_phase;                    // Phase of the flicker at time 0 (radians)
+} scene_t;
+
+// ADC model matched to the ESP32-C3 oneshot ADC at 12 dB attenuation
+typedef struct {
+    float noise_sigma;      // Gaussian noise in codes (1 sigma)
+    float offset_codes;     // Zero offset in codes
+    int dead_zone_codes;    // Readings below this clamp to 0 (low-end dead zone)
+} scene_adc_model_t;
+
+// Random generator state (xorshift32)
+typedef struct {
+    uint32_t state;
+} scene_rng_t;
+
+#define SCENE_ADC_MODEL_DEFAULT { .noise_sigma = 1.5f, .offset_codes = 0.0f, .dead_zone_codes = 0 }
+
+// Function prototypes
+void scene_rng_seed(scene_rng_t *rng, uint32_t seed);
+uint32_t scene_rng_next(scene_rng_t *rng);
+float scene_rng_uniform(scene_rng_t *rng);
+float scene_rng_gaussian(scene_rng_t *rng);
+
+const char *scene_kind_name(scene_kind_t kind);
+bool scene_kind_from_name(const char *name, scene_kind_t *kind);
+
+void scene_render(scene_t *scene, const scene_params_t *params, scene_rng_t *rng);
+void scene_random(scene_t *scene, scene_kind_t kind, scene_rng_t *rng);
+
+float scene_lux_at(const scene_t *scene, int row, int col, int64_t time_us);
+uint16_t scene_adc_code(float lux, const scene_adc_model_t *adc, scene_rng_t *rng);
+void scene_sample_frame(const scene_t *scene, const scene_adc_model_t *adc, scene_rng_t *rng,
+                        int64_t start_us, int64_t pixel_period_us, light_frame_t *frame);
+
+#endif // SCENE_GEN_H
@@ -0,0 +1,216 @@
+/*
+ * Simulated Sensor for 4x5 Camera Light Meter host build
+ * Implementation file
+ */
+
+#include "sim_sensor.h"
+#include "host_shim.h"
+#include <math.h>
+#include <strings.h>
+
+// Scene state
+static sim_scene_t current_scene = SIM_SCENE_UNIFORM;
+static float base_lux = 1000.0f;
+static float flicker_depth = 0.0f;
+static float flicker_hz = 100.0f;
+static scene_t scene;
+static scene_rng_t rng;
+
+// ADC model
+static scene_adc_model_t adc_model = SCENE_ADC_MODEL_DEFAULT;
+
+// Analog front end: shared column select and enable, one input node per row
+static float settle_tau_us = SIM_SENSOR_DEFAULT_TAU_US;
+static int routed_col = 0;
+static bool routed_enabled = false;
+static int64_t route_time_us = 0;
+static float node_start_v[FRAME_ROWS];
+static int last_sample = -1;
+
+/**
+ * Render the current scene
+ * Random families draw a new scene; a base level rescales its key illuminance
+ */
+static void render_scene(void) {
+    scene_params_t params = {
+        .kind = SCENE_FLAT,
+        .key_lux = base_lux,
+        .flicker_depth = flicker_depth,
+        .flicker_hz = flicker_hz,
+    };
+
+    switch (current_scene) {
+        case SIM_SCENE_GRADIENT:
+            // Brightest at the top row (negative y)
+            params.kind = SCENE_HDR_GRADIENT;
+            params.range_stops = 2.0f;
+            params.angle_rad = -1.5707963f;
+            scene_render(&scene, &params, &rng);
+            return;
+        case SIM_SCENE_HDR:
+        case SIM_SCENE_BACKLIGHT:
+        case SIM_SCENE_SPECULAR:
+        case SIM_SCENE_RANDOM: {
+            scene_kind_t kind = (current_scene == SIM_SCENE_HDR) ? SCENE_HDR_GRADIENT :
+                                (current_scene == SIM_SCENE_BACKLIGHT) ? SCENE_BACKLIGHT :
+                                (current_scene == SIM_SCENE_SPECULAR) ? SCENE_SPECULAR :
+                                (scene_kind_t)(scene_rng_next(&rng) % SCENE_KIND_COUNT);
+            scene_random(&scene, kind, &rng);
+
+            if (base_lux > 0.0f) {
+                float scale = base_lux / scene.params.key_lux;
+                for (int row = 0; row < FRAME_ROWS; row++) {
+                    for (int col = 0; col < FRAME_COLS; col++) {
+                        scene.lux[row][col] *= scale;
+                    }
+                }
+                scene.params.key_lux = base_lux;
+            }
+            if (flicker_depth > 0.0f) {
+                scene.params.flicker_depth = flicker_depth;
+                scene.params.flicker_hz = flicker_hz;
+            }
+            return;
+        }
+        case SIM_SCENE_CUSTOM:
+            return;
+        default:
+            break;
+    }
+
+    scene_render(&scene, &params, &rng);
+
+    if (current_scene == SIM_SCENE_SPOT) {
+        scene.lux[2][1] *= 4.0f;
+        scene.lux[2][2] *= 4.0f;
+    }
+}
+
+/**
+ * Initialize the simulated sensor
+ */
+void sim_sensor_init(uint32_t seed) {
+    scene_rng_seed(&rng, seed);
+    render_scene();
+}
+
+/**
+ * Select the scene and its base illuminance
+ */
+void sim_sensor_set_scene(sim_scene_t new_scene, float lux) {
+    current_scene = new_scene;
+    base_lux = lux;
+    render_scene();
+}
+
+/**
+ * Look up a scene by name
+ */
+bool sim_sensor_scene_from_name(const char *name, sim_scene_t *result) {
+    static const char *names[] = {
+        "uniform", "gradient", "spot", "hdr", "backlight", "specular", "random"
+    };
+
+    for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); i++) {
+        if (strcasecmp(name, names[i]) == 0) {
+            *result = (sim_scene_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Set the ADC noise level in codes
+ */
+void sim_sensor_set_noise(float sigma_codes) {
+    adc_model.noise_sigma = sigma_codes;
+}
+
+/**
+ * Light the scene with flickering (mains) lighting
+ */
+void sim_sensor_set_flicker(float depth, float hz) {
+    flicker_depth = depth;
+    flicker_hz = hz;
+    render_scene();
+}
+
+/**
+ * Put a fixed scene in front of the sensor
+ */
+void sim_sensor_load_scene(const scene_t *fixed) {
+    current_scene = SIM_SCENE_CUSTOM;
+    scene = *fixed;
+}
+
+/**
+ * Set the settling time constant of the input nodes (0: settle instantly)
+ */
+void sim_sensor_set_settle_tau(float tau_us) {
+    settle_tau_us = tau_us;
+}
+
+/**
+ * Get the scene currently in front of the sensor (ground truth)
+ */
+const scene_t *sim_sensor_current_scene(void) {
+    return &scene;
+}
+
+/**
+ * Voltage a row's input node is heading for at a time
+ */
+static float node_target_v(int row, int64_t time_us) {
+    if (!routed_enabled) {
+        return 0.0f;
+    }
+    return scene_lux_at(&scene, row, routed_col, time_us) * PHOTODIODE_SENSITIVITY * RLOAD_OHM;
+}
+
+/**
+ * Voltage of a row's input node, following its target since the last switch
+ */
+static float node_v(int row, int64_t time_us) {
+    float target = node_target_v(row, time_us);
+
+    if (settle_tau_us <= 0.0f) {
+        return target;
+    }
+
+    float decay = expf(-(float)(time_us - route_time_us) / settle_tau_us);
+    return target + (node_start_v[row] - target) * decay;
+}
+
+/**
+ * Switch the multiplexer column or enable line at the current virtual time
+ */
+void sim_sensor_route(int col, bool enabled) {
+    int64_t now = host_shim_time_us();
+
+    for (int row = 0; row < FRAME_ROWS; row++) {
+        node_start_v[row] = node_v(row, now);
+    }
+
+    routed_col = col;
+    routed_enabled = enabled;
+    route_time_us = now;
+}
+
+/**
+ * Convert a row's input node at the current virtual time
+ * The first conversion of pixel (0, 0) starts a new frame of a random scene
+ */
+int sim_sensor_sample(int row) {
+    int pixel = routed_enabled ? FRAME_INDEX(row, routed_col) : -1;
+
+    if (pixel == 0 && last_sample != 0 &&
+        current_scene >= SIM_SCENE_HDR && current_scene <= SIM_SCENE_RANDOM) {
+        render_scene();
+    }
+    last_sample = pixel;
+
+    float v = node_v(row, host_shim_time_us());
+    return scene_adc_code(lux_from_voltage(v), &adc_model, &rng);
+}
@@ -0,0 +1,46 @@
+/*
+ * Simulated Sensor for 4x5 Camera Light Meter host build
+ * Serves the ADC shim from a synthetic scene, sampled at the virtual clock time
+ *
+ * Each row's ADC input is modelled as a single-pole RC node: switching the
+ * multiplexer column or the enable line moves its target voltage, and the node
+ * follows with time constant tau. A conversion taken before the node has
+ * settled reads part of the previous pixel (or of the discharged input).
+ */
+
+#ifndef SIM_SENSOR_H
+#define SIM_SENSOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "scene_gen.h"
+
+// Built-in scenes
+typedef enum {
+    SIM_SCENE_UNIFORM,      // Every pixel at the base level
+    SIM_SCENE_GRADIENT,     // Two stops brighter at the top row than the bottom
+    SIM_SCENE_SPOT,         // Base level with a 4x hotspot in the spot-meter pixels
+    SIM_SCENE_HDR,          // New random HDR gradient on every frame
+    SIM_SCENE_BACKLIGHT,    // New random backlit subject on every frame
+    SIM_SCENE_SPECULAR,     // New random specular scene on every frame
+    SIM_SCENE_RANDOM,       // New random scene of any family on every frame
+    SIM_SCENE_CUSTOM        // Scene loaded with sim_sensor_load_scene()
+} sim_scene_t;
+
+// Default settling time constant of the photodiode/load/mux input node
+#define SIM_SENSOR_DEFAULT_TAU_US   20.0f
+
+// Function prototypes
+void sim_sensor_init(uint32_t seed);
+void sim_sensor_set_scene(sim_scene_t scene, float base_lux);
+bool sim_sensor_scene_from_name(const char *name, sim_scene_t *scene);
+void sim_sensor_set_noise(float sigma_codes);
+void sim_sensor_set_flicker(float depth, float hz);
+void sim_sensor_load_scene(const scene_t *scene);
+void sim_sensor_set_settle_tau(float tau_us);
+
+const scene_t *sim_sensor_current_scene(void);
+void sim_sensor_route(int col, bool enabled);
+int sim_sensor_sample(int row);
+
+#endif // SIM_SENSOR_H
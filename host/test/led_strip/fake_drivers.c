@@ -0,0 +1,247 @@
+/*
+ * 4x5 Camera Light Meter
+ * Fake RMT and SPI drivers for the led_strip host test
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "driver/rmt_tx.h"
+#include "driver/spi_master.h"
+#include "soc/spi_periph.h"
+#include "led_strip_rmt_encoder.h"
+#include "fake_drivers.h"
+
+#define FAKE_QUEUE      16
+
+const spi_signal_conn_t spi_periph_signal[3];
+fake_log_t fake_log;
+
+struct spi_device_t {
+    spi_device_interface_config_t config;
+    spi_transaction_t *queued[FAKE_QUEUE];  // Sent out in order by fake_spi_complete()
+    int queue_head;
+    int queue_tail;
+    spi_transaction_t *done[FAKE_QUEUE];    // Waiting for spi_device_get_trans_result()
+    int done_head;
+    int done_tail;
+};
+
+struct rmt_channel_t {
+    rmt_tx_event_callbacks_t callbacks;
+    void *user_data;
+    bool enabled;
+    const void *queued[FAKE_QUEUE];         // Payloads read out by fake_rmt_complete(), in order
+    size_t queued_bytes[FAKE_QUEUE];
+    int queue_head;
+    int queue_tail;
+};
+
+// One device of each kind at a time is enough for the test
+static struct spi_device_t *spi_device;
+static struct rmt_channel_t *rmt_channel;
+
+static void log_transfer(const void *payload, size_t bytes) {
+    fake_log.transfers++;
+    fake_log.bytes = bytes;
+    memcpy(fake_log.last, payload, bytes < FAKE_FRAME_MAX ? bytes : FAKE_FRAME_MAX);
+}
+
+void fake_log_reset(void) {
+    memset(&fake_log, 0, sizeof(fake_log));
+}
+
+/**
+ * Number of queued transfers not sent out yet
+ */
+int fake_in_flight(void) {
+    if (spi_device != NULL) {
+        return spi_device->queue_tail - spi_device->queue_head;
+    }
+    if (rmt_channel != NULL) {
+        return rmt_channel->queue_tail - rmt_channel->queue_head;
+    }
+    return 0;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma_chan) {
+    (void)host;
+    (void)config;
+    (void)dma_chan;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_free(spi_host_device_t host) {
+    (void)host;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config,
+                             spi_device_handle_t *handle) {
+    (void)host;
+    spi_device = calloc(1, sizeof(*spi_device));
+    if (spi_device == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    spi_device->config = *config;
+    *handle = spi_device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle) {
+    free(handle);
+    spi_device = NULL;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    // A blocking transfer goes out after everything already queued
+    while (fake_spi_complete()) {
+    }
+    fake_log.blocking++;
+    log_transfer(trans->tx_buffer, trans->length / 8);
+    if (handle->config.post_cb) {
+        handle->config.post_cb(trans);
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    if (handle->queue_tail - handle->queue_head >= handle->config.queue_size) {
+        return ESP_ERR_TIMEOUT;
+    }
+    handle->queued[handle->queue_tail++ % FAKE_QUEUE] = trans;
+    return ESP_OK;
+}
+
+/**
+ * Send out the oldest queued SPI transfer; false if none is in flight
+ */
+bool fake_spi_complete(void) {
+    struct spi_device_t *device = spi_device;
+
+    if (device == NULL || device->queue_head == device->queue_tail) {
+        return false;
+    }
+    spi_transaction_t *trans = device->queued[device->queue_head++ % FAKE_QUEUE];
+    log_transfer(trans->tx_buffer, trans->length / 8);
+    if (device->config.post_cb) {
+        device->config.post_cb(trans);
+    }
+    device->done[device->done_tail++ % FAKE_QUEUE] = trans;
+    return true;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans,
+                                      TickType_t ticks_to_wait) {
+    // Waiting lets the oldest transfer finish; polling only sees finished ones
+    if (handle->done_head == handle->done_tail && (ticks_to_wait == 0 || !fake_spi_complete())) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = handle->done[handle->done_head++ % FAKE_QUEUE];
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_actual_freq(spi_device_handle_t handle, int *freq_khz) {
+    (void)handle;
+    *freq_khz = 2500;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan) {
+    (void)config;
+    rmt_channel = calloc(1, sizeof(*rmt_channel));
+    if (rmt_channel == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    *ret_chan = rmt_channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel) {
+    free(channel);
+    rmt_channel = NULL;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel) {
+    if (channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel) {
+    if (!channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    channel->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder, const void *payload,
+                       size_t payload_bytes, const rmt_transmit_config_t *config) {
+    (void)encoder;
+    (void)config;
+    if (!tx_channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (tx_channel->queue_tail - tx_channel->queue_head >= FAKE_QUEUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    tx_channel->queued[tx_channel->queue_tail % FAKE_QUEUE] = payload;
+    tx_channel->queued_bytes[tx_channel->queue_tail % FAKE_QUEUE] = payload_bytes;
+    tx_channel->queue_tail++;
+    return ESP_OK;
+}
+
+/**
+ * Finish the oldest RMT transfer and run its done callback; false if none is in flight
+ */
+bool fake_rmt_complete(void) {
+    struct rmt_channel_t *channel = rmt_channel;
+    rmt_tx_done_event_data_t event = { 0 };
+
+    if (channel == NULL || channel->queue_head == channel->queue_tail) {
+        return false;
+    }
+    // Like the hardware, the payload is read while it goes out, not when it is queued
+    log_transfer(channel->queued[channel->queue_head % FAKE_QUEUE],
+                 channel->queued_bytes[channel->queue_head % FAKE_QUEUE]);
+    channel->queue_head++;
+    if (channel->callbacks.on_trans_done) {
+        channel->callbacks.on_trans_done(channel, &event, channel->user_data);
+    }
+    return true;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t tx_channel, int timeout_ms) {
+    (void)tx_channel;
+    if (timeout_ms == 0 && fake_in_flight() > 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    fake_log.blocking++;
+    while (fake_rmt_complete()) {
+    }
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t tx_channel, const rmt_tx_event_callbacks_t *cbs,
+                                          void *user_data) {
+    tx_channel->callbacks = *cbs;
+    tx_channel->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_led_strip_encoder(const led_strip_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder) {
+    (void)config;
+    *ret_encoder = (rmt_encoder_handle_t)&rmt_channel;    // Never dereferenced
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder) {
+    (void)encoder;
+    return ESP_OK;
+}
@@ -0,0 +1,33 @@
+/*
+ * 4x5 Camera Light Meter
+ * Fake RMT and SPI drivers for the led_strip host test
+ *
+ * Every transfer is logged instead of sent. Blocking calls complete at once;
+ * queued ones stay in flight until the test completes them, so a refresh can
+ * be issued while the previous transfer is still going out.
+ */
+
+#ifndef FAKE_DRIVERS_H
+#define FAKE_DRIVERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define FAKE_FRAME_MAX  4096
+
+typedef struct {
+    int transfers;                          // Transfers sent out
+    int blocking;                           // Blocking transmit or wait calls
+    size_t bytes;                           // Length of the last transfer
+    unsigned char last[FAKE_FRAME_MAX];     // Payload of the last transfer
+} fake_log_t;
+
+extern fake_log_t fake_log;
+
+// Function prototypes
+void fake_log_reset(void);
+bool fake_spi_complete(void);
+bool fake_rmt_complete(void);
+int fake_in_flight(void);
+
+#endif // FAKE_DRIVERS_H
@@ -0,0 +1,13 @@
+/*
+ * led_strip test stubs: RMT encoders
+ */
+
+#ifndef DRIVER_RMT_ENCODER_H
+#define DRIVER_RMT_ENCODER_H
+
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+
+esp_err_t rmt_del_encoder(rmt_encoder_handle_t encoder);
+
+#endif // DRIVER_RMT_ENCODER_H
@@ -0,0 +1,28 @@
+/*
+ * led_strip test stubs: capability-based allocation, served by malloc
+ */
+
+#ifndef ESP_HEAP_CAPS_H
+#define ESP_HEAP_CAPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define BIT(n)                  (1UL << (n))
+
+#define MALLOC_CAP_DMA          BIT(3)
+#define MALLOC_CAP_INTERNAL     BIT(11)
+#define MALLOC_CAP_DEFAULT      BIT(12)
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps) {
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+    (void)caps;
+    return calloc(n, size);
+}
+
+#endif // ESP_HEAP_CAPS_H
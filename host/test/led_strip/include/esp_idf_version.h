@@ -0,0 +1,11 @@
+/*
+ * led_strip test stubs: the ESP-IDF version the component is built for
+ */
+
+#ifndef ESP_IDF_VERSION_H
+#define ESP_IDF_VERSION_H
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(5, 4, 0)
+
+#endif // ESP_IDF_VERSION_H
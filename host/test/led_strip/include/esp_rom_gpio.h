@@ -0,0 +1,19 @@
+/*
+ * led_strip test stubs: GPIO matrix routing (nothing to route on the host)
+ */
+
+#ifndef ESP_ROM_GPIO_H
+#define ESP_ROM_GPIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+static inline void esp_rom_gpio_connect_out_signal(uint32_t gpio_num, uint32_t signal_idx,
+                                                   bool out_inv, bool oen_inv) {
+    (void)gpio_num;
+    (void)signal_idx;
+    (void)out_inv;
+    (void)oen_inv;
+}
+
+#endif // ESP_ROM_GPIO_H
@@ -0,0 +1,8 @@
+/*
+ * led_strip test stubs: SPI HAL (nothing used beyond the driver API)
+ */
+
+#ifndef HAL_SPI_HAL_H
+#define HAL_SPI_HAL_H
+
+#endif // HAL_SPI_HAL_H
@@ -0,0 +1,16 @@
+/*
+ * led_strip test stubs: forced include for what newlib's sys/cdefs.h provides
+ * on the device but glibc's does not, and the assert() the IDF headers pull in
+ */
+
+#ifndef LED_STRIP_TEST_PRELUDE_H
+#define LED_STRIP_TEST_PRELUDE_H
+
+#include <assert.h>
+#include <stddef.h>
+
+#ifndef __containerof
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+#endif // LED_STRIP_TEST_PRELUDE_H
@@ -0,0 +1,16 @@
+/*
+ * led_strip test stubs: SPI peripheral signals
+ */
+
+#ifndef SOC_SPI_PERIPH_H
+#define SOC_SPI_PERIPH_H
+
+#include "esp_rom_sys.h"
+
+typedef struct {
+    int spid_out;
+} spi_signal_conn_t;
+
+extern const spi_signal_conn_t spi_periph_signal[3];
+
+#endif // SOC_SPI_PERIPH_H
@@ -0,0 +1,110 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host test for the reference-counted frame pool (main/frame_pool.c)
+ *
+ * Exits nonzero if any check fails.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "host_shim.h"
+#include "frame_pool.h"
+
+static int failures;
+
+#define CHECK(cond) do {                                                    \
+        if (!(cond)) {                                                      \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+/**
+ * Every frame can be acquired once; the next acquisition finds none free until
+ * one is released, and it then gets that frame back
+ */
+static void test_exhaustion(void) {
+    light_frame_t *frames[FRAME_POOL_SIZE];
+    frame_pool_stats_t stats;
+
+    frame_pool_init();
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        frames[i] = frame_pool_acquire();
+        CHECK(frames[i] != NULL);
+        CHECK(frame_pool_refcount(frames[i]) == 1);
+        for (int j = 0; j < i; j++) {
+            CHECK(frames[i] != frames[j]);
+        }
+    }
+
+    CHECK(frame_pool_acquire() == NULL);
+    CHECK(frame_pool_acquire() == NULL);
+    frame_pool_get_stats(&stats);
+    CHECK(stats.acquired == FRAME_POOL_SIZE);
+    CHECK(stats.exhausted == 2);
+    CHECK(stats.in_use == FRAME_POOL_SIZE);
+    CHECK(stats.peak_in_use == FRAME_POOL_SIZE);
+
+    frame_pool_release(frames[1]);
+    CHECK(frame_pool_acquire() == frames[1]);
+
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        frame_pool_release(frames[i]);
+    }
+    frame_pool_get_stats(&stats);
+    CHECK(stats.in_use == 0);
+    CHECK(stats.peak_in_use == FRAME_POOL_SIZE);
+}
+
+/**
+ * A frame stays in use until its last reference is released; after that a
+ * stale pointer can neither take a reference nor be released again
+ */
+static void test_references(void) {
+    light_frame_t outside;
+    frame_pool_stats_t stats;
+
+    frame_pool_init();
+    light_frame_t *frame = frame_pool_acquire();
+    CHECK(frame != NULL);
+    if (frame == NULL) {
+        return;
+    }
+
+    CHECK(frame_pool_ref(frame) == frame);
+    CHECK(frame_pool_refcount(frame) == 2);
+    frame_pool_release(frame);
+    CHECK(frame_pool_refcount(frame) == 1);
+    frame_pool_get_stats(&stats);
+    CHECK(stats.in_use == 1);
+
+    frame_pool_release(frame);
+    CHECK(frame_pool_refcount(frame) == 0);
+    frame_pool_get_stats(&stats);
+    CHECK(stats.in_use == 0);
+
+    // Released: no revival, and an extra release does not wrap the count
+    CHECK(frame_pool_ref(frame) == NULL);
+    CHECK(frame_pool_refcount(frame) == 0);
+    frame_pool_release(frame);
+    CHECK(frame_pool_refcount(frame) == 0);
+    frame_pool_get_stats(&stats);
+    CHECK(stats.in_use == 0);
+
+    // Frames that are not from the pool are refused
+    CHECK(frame_pool_ref(&outside) == NULL);
+    CHECK(frame_pool_refcount(&outside) == 0);
+    frame_pool_release(NULL);
+}
+
+int main(void) {
+    // The pool logs misuse as errors; those are expected here
+    host_shim_set_log_level(ESP_LOG_NONE);
+
+    test_exhaustion();
+    test_references();
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,277 @@
+/*
+ * 4x5 Camera Light Meter
+ * Host test for the led_strip fork in components/led_strip
+ *
+ * Builds the component's RMT and SPI backends against fake drivers that log
+ * each transfer instead of sending it, and checks what reaches the wire.
+ * Exits nonzero if any check fails.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "led_strip.h"
+#include "fake_drivers.h"
+
+#define STRIP_LEDS      20
+
+static int failures;
+
+#define CHECK(cond) do {                                                    \
+        if (!(cond)) {                                                      \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+typedef enum {
+    BACKEND_RMT,
+    BACKEND_SPI,
+} backend_t;
+
+static const char *backend_name(backend_t backend) {
+    return backend == BACKEND_SPI ? "spi" : "rmt";
+}
+
+static led_strip_handle_t new_strip(backend_t backend, uint32_t leds, led_pixel_format_t format) {
+    led_strip_config_t strip_config = {
+        .strip_gpio_num = 1,
+        .max_leds = leds,
+        .led_pixel_format = format,
+        .led_model = LED_MODEL_WS2812,
+    };
+    led_strip_handle_t strip = NULL;
+
+    fake_log_reset();
+    if (backend == BACKEND_SPI) {
+        led_strip_spi_config_t spi_config = { .spi_bus = 1 };
+        CHECK(led_strip_new_spi_device(&strip_config, &spi_config, &strip) == ESP_OK);
+    } else {
+        led_strip_rmt_config_t rmt_config = { 0 };
+        CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &strip) == ESP_OK);
+    }
+    return strip;
+}
+
+/* ---- led_strip_set_pixels ---- */
+
+/**
+ * A frame set in blocks through led_strip_set_pixels() goes out exactly as the
+ * same frame set pixel by pixel
+ */
+static void test_set_pixels(backend_t backend, led_pixel_format_t format) {
+    led_strip_handle_t strip = new_strip(backend, STRIP_LEDS, format);
+    uint8_t rgb[STRIP_LEDS * 3];
+    uint8_t expected[FAKE_FRAME_MAX];
+    size_t expected_bytes;
+
+    if (strip == NULL) {
+        return;
+    }
+    for (int i = 0; i < STRIP_LEDS * 3; i++) {
+        rgb[i] = (uint8_t)(i * 37 + 5);
+    }
+
+    for (int i = 0; i < STRIP_LEDS; i++) {
+        CHECK(led_strip_set_pixel(strip, i, rgb[3 * i], rgb[3 * i + 1], rgb[3 * i + 2]) == ESP_OK);
+    }
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    expected_bytes = fake_log.bytes;
+    memcpy(expected, fake_log.last, expected_bytes);
+
+    CHECK(led_strip_clear(strip) == ESP_OK);
+    CHECK(led_strip_set_pixels(strip, 0, 5, rgb) == ESP_OK);
+    CHECK(led_strip_set_pixels(strip, 5, STRIP_LEDS - 5, rgb + 15) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.bytes == expected_bytes);
+    CHECK(memcmp(fake_log.last, expected, expected_bytes) == 0);
+
+    // An empty block at the end is fine, one running past it or wrapping is not
+    CHECK(led_strip_set_pixels(strip, STRIP_LEDS, 0, NULL) == ESP_OK);
+    CHECK(led_strip_set_pixels(strip, STRIP_LEDS - 2, 3, rgb) == ESP_ERR_INVALID_ARG);
+    CHECK(led_strip_set_pixels(strip, UINT32_MAX, 2, rgb) == ESP_ERR_INVALID_ARG);
+
+    CHECK(led_strip_del(strip) == ESP_OK);
+}
+
+/* ---- led_strip_refresh_async ---- */
+
+static int done_calls;
+
+static bool count_done(led_strip_handle_t strip, void *user_ctx) {
+    (void)strip;
+    (*(int *)user_ctx)++;
+    return false;
+}
+
+static bool complete_one(backend_t backend) {
+    return backend == BACKEND_SPI ? fake_spi_complete() : fake_rmt_complete();
+}
+
+/**
+ * An asynchronous refresh sends a snapshot of the frame, so the next one can be
+ * set while it is in flight; a second refresh issued meanwhile is refused
+ * rather than queued, and synchronous refreshes and deletion wait for it.
+ * Every frame changes the last LED so each one is sent whole.
+ */
+static void test_refresh_async(backend_t backend) {
+    led_strip_handle_t strip = new_strip(backend, 4, LED_PIXEL_FORMAT_GRB);
+    uint8_t frame_a[FAKE_FRAME_MAX];
+    uint8_t frame_b[FAKE_FRAME_MAX];
+    size_t frame_bytes;
+    int transfers;
+
+    if (strip == NULL) {
+        return;
+    }
+    done_calls = 0;
+    CHECK(led_strip_clear(strip) == ESP_OK);
+
+    // Reference frames from synchronous refreshes
+    CHECK(led_strip_set_pixel(strip, 3, 10, 20, 30) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    frame_bytes = fake_log.bytes;
+    memcpy(frame_a, fake_log.last, frame_bytes);
+    CHECK(led_strip_set_pixel(strip, 3, 1, 2, 3) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.bytes == frame_bytes);
+    memcpy(frame_b, fake_log.last, frame_bytes);
+    CHECK(fake_in_flight() == 0);
+
+    // Frame A in flight while frame B is set; a refresh of B meanwhile is refused
+    transfers = fake_log.transfers;
+    CHECK(led_strip_set_pixel(strip, 3, 10, 20, 30) == ESP_OK);
+    CHECK(led_strip_refresh_async(strip, count_done, &done_calls) == ESP_OK);
+    CHECK(fake_in_flight() == 1);
+    CHECK(led_strip_set_pixel(strip, 3, 1, 2, 3) == ESP_OK);
+    CHECK(led_strip_refresh_async(strip, count_done, &done_calls) == ESP_ERR_INVALID_STATE);
+    CHECK(led_strip_wait_refresh_done(strip, 0) == ESP_ERR_TIMEOUT);
+    CHECK(fake_in_flight() == 1);
+    CHECK(done_calls == 0);
+
+    CHECK(complete_one(backend));
+    CHECK(fake_log.bytes == frame_bytes);
+    CHECK(memcmp(fake_log.last, frame_a, frame_bytes) == 0);
+    CHECK(done_calls == 1);
+
+    // B goes out once A is collected
+    CHECK(led_strip_refresh_async(strip, count_done, &done_calls) == ESP_OK);
+    CHECK(led_strip_wait_refresh_done(strip, -1) == ESP_OK);
+    CHECK(memcmp(fake_log.last, frame_b, frame_bytes) == 0);
+    CHECK(done_calls == 2);
+    CHECK(fake_log.transfers == transfers + 2);
+    CHECK(led_strip_wait_refresh_done(strip, 0) == ESP_OK);
+
+    // A synchronous refresh queues behind one in flight, whose callback still runs
+    CHECK(led_strip_set_pixel(strip, 3, 10, 20, 30) == ESP_OK);
+    CHECK(led_strip_refresh_async(strip, count_done, &done_calls) == ESP_OK);
+    CHECK(led_strip_set_pixel(strip, 3, 1, 2, 3) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_in_flight() == 0);
+    CHECK(fake_log.transfers == transfers + 4);
+    CHECK(memcmp(fake_log.last, frame_b, frame_bytes) == 0);
+    CHECK(done_calls == 3);
+
+    // Deleting the strip lets a refresh in flight finish first
+    CHECK(led_strip_set_pixel(strip, 3, 10, 20, 30) == ESP_OK);
+    CHECK(led_strip_refresh_async(strip, count_done, &done_calls) == ESP_OK);
+    CHECK(led_strip_del(strip) == ESP_OK);
+    CHECK(fake_log.transfers == transfers + 5);
+    CHECK(done_calls == 4);
+}
+
+/* ---- Dirty prefix ---- */
+
+static bool count_done_only(led_strip_handle_t strip, void *user_ctx) {
+    (void)strip;
+    (void)user_ctx;
+    done_calls++;
+    return false;
+}
+
+/**
+ * Refreshes send only the pixels up to the last one whose color changed, and
+ * nothing at all when none did; clearing always sends the whole strip
+ */
+static void test_dirty_prefix(backend_t backend, led_pixel_format_t format) {
+    led_strip_handle_t strip = new_strip(backend, 8, format);
+    size_t color_bytes = format == LED_PIXEL_FORMAT_GRBW ? 4 : 3;
+    // The SPI backend encodes every data bit as three bits on the wire
+    size_t pixel_bytes = backend == BACKEND_SPI ? color_bytes * 3 : color_bytes;
+    uint8_t rgb[9] = { 1, 1, 1, 9, 9, 9, 0, 0, 0 };
+    uint8_t prefix[FAKE_FRAME_MAX];
+    int transfers;
+
+    if (strip == NULL) {
+        return;
+    }
+    CHECK(led_strip_clear(strip) == ESP_OK);
+    CHECK(fake_log.bytes == 8 * pixel_bytes);
+    transfers = fake_log.transfers;
+
+    // Nothing changed, or set to the color it already has
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(led_strip_set_pixel(strip, 2, 0, 0, 0) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.transfers == transfers);
+
+    CHECK(led_strip_set_pixel(strip, 2, 5, 6, 7) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.transfers == transfers + 1);
+    CHECK(fake_log.bytes == 3 * pixel_bytes);
+    memcpy(prefix, fake_log.last, fake_log.bytes);
+
+    // The prefix reaches the furthest change and still carries unchanged pixels before it
+    CHECK(led_strip_set_pixel(strip, 5, 1, 1, 1) == ESP_OK);
+    CHECK(led_strip_set_pixel(strip, 1, 1, 1, 1) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.bytes == 6 * pixel_bytes);
+    CHECK(memcmp(fake_log.last + 2 * pixel_bytes, prefix + 2 * pixel_bytes, pixel_bytes) == 0);
+
+    // Only pixel 6 of the block changes
+    CHECK(led_strip_set_pixels(strip, 5, 3, rgb) == ESP_OK);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.bytes == 7 * pixel_bytes);
+
+    // An asynchronous refresh with nothing to send calls back at once
+    done_calls = 0;
+    transfers = fake_log.transfers;
+    CHECK(led_strip_refresh_async(strip, count_done_only, NULL) == ESP_OK);
+    CHECK(done_calls == 1);
+    CHECK(fake_log.transfers == transfers);
+
+    // A pixel changed while its refresh is in flight is sent by the next one
+    CHECK(led_strip_set_pixel(strip, 0, 3, 3, 3) == ESP_OK);
+    CHECK(led_strip_refresh_async(strip, count_done_only, NULL) == ESP_OK);
+    CHECK(done_calls == 1);
+    CHECK(led_strip_set_pixel(strip, 0, 4, 4, 4) == ESP_OK);
+    CHECK(led_strip_wait_refresh_done(strip, -1) == ESP_OK);
+    CHECK(done_calls == 2);
+    CHECK(fake_log.bytes == pixel_bytes);
+    CHECK(led_strip_refresh(strip) == ESP_OK);
+    CHECK(fake_log.transfers == transfers + 2);
+    CHECK(fake_log.bytes == pixel_bytes);
+
+    CHECK(led_strip_clear(strip) == ESP_OK);
+    CHECK(fake_log.bytes == 8 * pixel_bytes);
+    CHECK(led_strip_del(strip) == ESP_OK);
+}
+
+int main(void) {
+    static const backend_t backends[] = { BACKEND_RMT, BACKEND_SPI };
+
+    for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); i++) {
+        int before = failures;
+
+        test_set_pixels(backends[i], LED_PIXEL_FORMAT_GRB);
+        test_set_pixels(backends[i], LED_PIXEL_FORMAT_GRBW);
+        test_refresh_async(backends[i]);
+        test_dirty_prefix(backends[i], LED_PIXEL_FORMAT_GRB);
+        test_dirty_prefix(backends[i], LED_PIXEL_FORMAT_GRBW);
+        printf("%s: %s\n", backend_name(backends[i]), failures == before ? "ok" : "FAILED");
+    }
+
+    printf("%s (%d failures)\n", failures ? "FAILED" : "ok", failures);
+    return failures ? 1 : 0;
+}
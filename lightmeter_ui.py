@@ -1,12 +1,481 @@
 import tkinter as tk
-from tkinter import ttk, scrolledtext, messagebox
+from tkinter import ttk, scrolledtext, messagebox, filedialog
 import serial
 import serial.tools.list_ports
 import threading
+import queue
 import time
 import re
 import random  # For demo mode
 import math
+import glob
+import collections
+import struct
+import sys
+import argparse
+
+# Serial read timeout in seconds; reads return early as soon as data arrives
+SERIAL_READ_TIMEOUT = 0.05
+
+# Interval at which the Tk thread drains messages from the serial reader
+RX_POLL_MS = 5
+
+# Longest unterminated output kept while waiting for a newline (a CAL line is ~4 KB)
+MAX_LINE_BYTES = 16384
+
+# Lines kept in the console; older output is dropped
+CONSOLE_MAX_LINES = 2000
+
+# Console output is batched and inserted at most once per frame (~60 Hz)
+CONSOLE_FLUSH_MS = 16
+
+# Device result lines, compiled once and matched on the serial reader thread
+SHUTTER_RE = re.compile(r'ISO (\d+), ([\d/\.]+)\s*(?:seconds)?\s*\(EV: ([\d\.]+)\)')
+MODE_RE = re.compile(r'Metering mode: (\w+)')
+K_VALUE_RE = re.compile(r'K value: ([\d\.]+)')
+
+# Live heatmap: render at most ~30 fps from a buffer the reader fills
+HEATMAP_FRAME_MS = 33
+HEATMAP_BUFFER_FRAMES = 64
+HEATMAP_INTERP_STEPS = 4  # Sub-cells per pixel side in the interpolated view
+
+# False color for zones 0-X, zone V being the metered EV
+ZONE_COLORS = ["#1a0033", "#2d0a78", "#1f3fbf", "#1f8fd9", "#3fbfa0", "#7f7f7f",
+               "#8fd13f", "#e6e62e", "#f2a11f", "#e8491d", "#ffffff"]
+ZONE_NAMES = ["0", "I", "II", "III", "IV", "V", "VI", "VII", "VIII", "IX", "X"]
+
+# Sensor conversion as in light_frame.h
+FRAME_ROWS = 5
+FRAME_COLS = 4
+ADC_SATURATION_CODE = 4090
+MIN_RELIABLE_LUX = 10.0
+LUX_PER_VOLT = 1.0 / (0.0057e-6 * 1300)
+
+# Session files: a magic line, then one record per serial chunk, each a header
+# (microseconds since the previous chunk, length) and the bytes as they crossed
+# the port; the top bit of the length marks bytes sent to the device
+SESSION_MAGIC = b"LMSESSION1\n"
+SESSION_RECORD = struct.Struct("<IH")
+SESSION_TX = 0x8000
+SESSION_MAX_CHUNK = 0x7FFF
+
+class SessionRecorder:
+    """Appends timestamped serial traffic to a session file
+    Written from both the reader thread (received) and the Tk thread (sent)"""
+    def __init__(self, path):
+        self.file = open(path, "wb")
+        self.file.write(SESSION_MAGIC)
+        self.lock = threading.Lock()
+        self.last = time.monotonic()
+        self.bytes = 0
+    
+    def write(self, data, sent=False):
+        with self.lock:
+            if self.file is None:
+                return
+            now = time.monotonic()
+            delta_us = min(int((now - self.last) * 1e6), 0xFFFFFFFF)
+            self.last = now
+            for start in range(0, len(data), SESSION_MAX_CHUNK):
+                chunk = data[start:start + SESSION_MAX_CHUNK]
+                self.file.write(SESSION_RECORD.pack(delta_us, len(chunk) | (SESSION_TX if sent else 0)))
+                self.file.write(chunk)
+                delta_us = 0
+            self.bytes += len(data)
+    
+    def close(self):
+        with self.lock:
+            self.file.close()
+            self.file = None
+
+def read_session(path):
+    """Yield (delta us, sent, bytes) for each chunk of a session file"""
+    with open(path, "rb") as f:
+        if f.read(len(SESSION_MAGIC)) != SESSION_MAGIC:
+            raise ValueError("not a session recording")
+        while True:
+            header = f.read(SESSION_RECORD.size)
+            if len(header) < SESSION_RECORD.size:
+                return
+            delta_us, length = SESSION_RECORD.unpack(header)
+            data = f.read(length & SESSION_MAX_CHUNK)
+            yield delta_us, bool(length & SESSION_TX), data
+
+def parse_calibration(line):
+    """Decode a CAL line into a per-code mV table, or None"""
+    fields = line.split(",", 4)
+    if len(fields) != 5 or fields[0] != "CAL" or fields[1] != "1":
+        return None
+    try:
+        codes = int(fields[2])
+        mv = int(fields[3])
+        table = [mv]
+        deltas = fields[4]
+        i = 0
+        while len(table) < codes:
+            if deltas[i] == "(":
+                end = deltas.index(")", i)
+                mv += int(deltas[i + 1:end])
+                i = end + 1
+            else:
+                mv += int(deltas[i])
+                i += 1
+            table.append(mv)
+    except (ValueError, IndexError):
+        return None
+    return table
+
+def parse_record(line):
+    """Decode a REC line (frame_record.h) into a dict, or None"""
+    # A record can follow the console prompt on the same line
+    while line.startswith("> "):
+        line = line[2:]
+    fields = line.split(",")
+    if len(fields) != 8 + FRAME_ROWS * FRAME_COLS or fields[0] != "REC" or fields[1] != "1":
+        return None
+    try:
+        return {
+            "seq": int(fields[2]),
+            "time_us": int(fields[3]),
+            "iso": int(fields[4]),
+            "mode": fields[5],
+            "k_value": float(fields[6]),
+            "ev": float(fields[7]),
+            "raw": [int(raw) for raw in fields[8:]],
+        }
+    except ValueError:
+        return None
+
+def heatmap_frame(lux_values, ev, ev_of_lux, saturated):
+    """Per-pixel EV of a frame for the heatmap; unreliable pixels are None"""
+    return {
+        "ev": ev,
+        "pixel_ev": [ev_of_lux(lux) if lux >= MIN_RELIABLE_LUX else None for lux in lux_values],
+        "saturated": saturated,
+    }
+
+def frame_from_record(record, mv_table, sampled=None):
+    """Heatmap frame from a REC record, with lux from the CAL table when one was sent
+    sampled is the frame's host time, from the clock sync or its arrival"""
+    lux_values = []
+    for raw in record["raw"]:
+        if mv_table and raw < len(mv_table):
+            volts = mv_table[raw] / 1000.0
+        else:
+            # Uncalibrated conversion, as get_voltage_from_adc()
+            volts = raw * 3.3 / 4095.0
+        lux_values.append(volts * LUX_PER_VOLT)
+    
+    # Device EV is log2(lux / K), ISO being applied to the shutter speed
+    k_value = record["k_value"] if record["k_value"] > 0 else 1e-6
+    frame = heatmap_frame(lux_values, record["ev"], lambda lux: math.log2(lux / k_value),
+                          [raw >= ADC_SATURATION_CODE for raw in record["raw"]])
+    frame["sampled"] = sampled
+    return frame
+
+def parse_response(text):
+    """Extract display settings from one line of device output
+    Returns a dict of changed attributes, or None if the line carries none"""
+    updates = {}
+    
+    # Extract shutter speed and EV
+    shutter_match = SHUTTER_RE.search(text)
+    if shutter_match:
+        updates["iso"] = int(shutter_match.group(1))
+        updates["shutter_speed"] = shutter_match.group(2)
+        updates["ev_value"] = shutter_match.group(3)
+    
+    # Extract metering mode
+    mode_match = MODE_RE.search(text)
+    if mode_match:
+        updates["metering_type"] = mode_match.group(1).lower()
+    
+    # Extract K value
+    k_match = K_VALUE_RE.search(text)
+    if k_match:
+        updates["k_value"] = float(k_match.group(1))
+    
+    return updates or None
+
+def split_lines(buffer):
+    """Remove and yield every complete line in a bytearray, keeping any partial line
+    Unterminated output beyond MAX_LINE_BYTES is yielded as a line of its own"""
+    while True:
+        end = buffer.find(b'\n')
+        if end < 0:
+            break
+        line = buffer[:end].decode('utf-8', errors='replace').rstrip('\r')
+        del buffer[:end + 1]
+        yield line
+    
+    if len(buffer) > MAX_LINE_BYTES:
+        line = buffer.decode('utf-8', errors='replace')
+        buffer.clear()
+        yield line
+
+def format_shutter(ev):
+    """Shutter speed for an EV as the device prints it (1/2^EV seconds)"""
+    t = 1.0 / pow(2.0, ev)
+    return f"1/{int(round(1 / t))}" if t < 1 else f"{t:.1f} seconds"
+
+# Multi-device rigs
+RIG_POLL_MS = 20
+RIG_SKEW_HISTORY = 200
+
+# Clock sync: a burst of pings on connect, then one per interval; the fastest
+# round trips of a sliding window are fitted
+SYNC_INTERVAL_S = 1.0
+SYNC_BURST = 8
+SYNC_BURST_INTERVAL_S = 0.1
+SYNC_WINDOW = 64
+SYNC_BEST_FRACTION = 0.25
+SYNC_MIN_SPAN_S = 10.0  # Device time covered before drift is fitted
+SYNC_MAX_PENDING = 16
+
+class ClockSync:
+    """Maps device esp_timer microseconds to host time from ping/echo exchanges
+    Each 'sync' reply pairs the device time with the midpoint of the host send
+    and receive times, which is off by at most half the round trip. Round trips
+    inflated by serial buffering or a busy device are dropped by fitting only
+    the fastest of the recent samples: an offset at first, then offset and drift
+    by least squares once the samples span SYNC_MIN_SPAN_S."""
+    def __init__(self):
+        self.samples = collections.deque(maxlen=SYNC_WINDOW)
+        self.pending = {}
+        self.next_token = 1
+        self.origin_us = None
+        self.intercept = None
+        self.slope = 1.0
+        self.error = None
+        self.next_ping = 0.0
+    
+    def due(self, now):
+        """Whether a ping is due at host time now: a burst first, then one per interval"""
+        if now < self.next_ping:
+            return False
+        burst = len(self.samples) < SYNC_BURST
+        self.next_ping = now + (SYNC_BURST_INTERVAL_S if burst else SYNC_INTERVAL_S)
+        return True
+    
+    def ping(self, now):
+        """Token for a ping sent at host time now"""
+        token = self.next_token
+        self.next_token += 1
+        self.expect(token, now)
+        return token
+    
+    def expect(self, token, sent):
+        """Await the reply to a ping sent at host time sent (also one replayed from a session)"""
+        self.pending[token] = sent
+        # Unanswered pings (lost lines, a reset) are forgotten eventually
+        if len(self.pending) > SYNC_MAX_PENDING:
+            del self.pending[next(iter(self.pending))]
+    
+    def reply(self, token, device_us, received):
+        sent = self.pending.pop(token, None)
+        if sent is None:
+            return
+        if self.origin_us is None:
+            self.origin_us = device_us
+        self.samples.append(((device_us - self.origin_us) / 1e6, (sent + received) / 2, received - sent))
+        self.fit()
+    
+    def fit(self):
+        best = sorted(self.samples, key=lambda sample: sample[2])
+        best = best[:max(1, int(len(best) * SYNC_BEST_FRACTION))]
+        n = len(best)
+        mean_x = sum(x for x, _, _ in best) / n
+        mean_y = sum(y for _, y, _ in best) / n
+        var_x = sum((x - mean_x) ** 2 for x, _, _ in best)
+        
+        span = max(x for x, _, _ in best) - min(x for x, _, _ in best)
+        if n >= 2 and span >= SYNC_MIN_SPAN_S:
+            self.slope = sum((x - mean_x) * (y - mean_y) for x, y, _ in best) / var_x
+        self.intercept = mean_y - self.slope * mean_x
+        self.error = best[0][2] / 2
+    
+    @property
+    def synced(self):
+        return self.intercept is not None
+    
+    @property
+    def drift_ppm(self):
+        return (self.slope - 1.0) * 1e6
+    
+    def to_host(self, device_us):
+        """Host time of a device timestamp, None before the first reply"""
+        if not self.synced:
+            return None
+        return self.intercept + self.slope * (device_us - self.origin_us) / 1e6
+
+class MeterDevice:
+    """One meter on its own serial port, read by its own thread
+    Output is framed and parsed on that thread and posted to a queue shared
+    by all devices, tagged with the device:
+      ("line", device, text), ("record", device, record, host time),
+      ("prompt", device, None) when the console waits for the next command,
+      ("closed", device, None)"""
+    def __init__(self, name, port, events):
+        self.name = name
+        self.port = port
+        self.events = events
+        self.serial = None
+        self.thread = None
+        self.running = False
+        self.calibration = None
+        self.write_lock = threading.Lock()
+        self.clock = ClockSync()
+        self.sync_enabled = False
+        self.at_prompt = False
+    
+    def open(self, sync=True):
+        self.serial = serial.Serial(self.port, 115200, timeout=SERIAL_READ_TIMEOUT)
+        self.sync_enabled = sync
+        self.running = True
+        self.thread = threading.Thread(target=self.read, daemon=True)
+        self.thread.start()
+    
+    def close(self):
+        self.running = False
+        if self.thread:
+            self.thread.join(timeout=1)
+        if self.serial:
+            self.serial.close()
+            self.serial = None
+    
+    def write(self, text):
+        # Sync pings are sent from the reader thread
+        with self.write_lock:
+            self.serial.write(text.encode('utf-8'))
+    
+    def sync_due(self, now):
+        return self.sync_enabled and self.clock.due(now)
+    
+    def frame_time(self, record, received):
+        """Host time at which a frame was sampled, or its receive time before sync"""
+        host_time = self.clock.to_host(record["time_us"])
+        return host_time if host_time is not None else received
+    
+    def read(self):
+        buffer = bytearray()
+        while self.running:
+            if self.sync_due(time.time()):
+                try:
+                    self.write(f"sync {self.clock.ping(time.time())}\n")
+                except Exception:
+                    pass
+            
+            try:
+                data = self.serial.read(self.serial.in_waiting or 1)
+            except Exception as e:
+                self.events.put(("line", self, f"Serial error: {str(e)}"))
+                break
+            if not data:
+                continue
+            
+            # Everything in this chunk arrived by now; the closest host time we have
+            received = time.time()
+            buffer.extend(data)
+            for line in split_lines(buffer):
+                self.handle_line(line, received)
+            if buffer == b"> " and not self.at_prompt:
+                self.at_prompt = True
+                self.events.put(("prompt", self, None))
+        
+        self.events.put(("closed", self, None))
+    
+    def handle_line(self, line, received):
+        # A prompt can share its line with later output, such as the echo of a
+        # ping sent while the console was busy; it still ends the command
+        body = line
+        prompted = False
+        while body.startswith("> "):
+            body = body[2:]
+            prompted = True
+        if prompted and not self.at_prompt:
+            self.events.put(("prompt", self, None))
+        self.at_prompt = False
+        
+        if body.startswith("SYNC,"):
+            fields = body.split(",")
+            try:
+                self.clock.reply(int(fields[1]), int(fields[2]), received)
+            except (ValueError, IndexError):
+                pass
+            return
+        if body.startswith("sync "):
+            return  # The console's echo of a ping
+        if body.startswith("CAL,"):
+            self.calibration = parse_calibration(body) or self.calibration
+            return
+        record = parse_record(body) if "REC," in body else None
+        if record:
+            self.events.put(("record", self, record, received))
+        else:
+            # Unstripped, so consumers can still tell command echoes by their prompt
+            self.events.put(("line", self, line))
+
+class FrameMerger:
+    """Time-aligns frames from several devices into sets
+    Each device's newest frame is held until every device has one; the set is
+    then emitted with its skew (latest minus earliest timestamp). A device that
+    delivers again before the set completes replaces its frame, so a set never
+    pairs a stale frame with fresh ones."""
+    def __init__(self, names):
+        self.names = list(names)
+        self.held = {}
+        self.skews = collections.deque(maxlen=RIG_SKEW_HISTORY)
+        self.sets = 0
+    
+    def add(self, name, record, timestamp):
+        self.held[name] = (record, timestamp)
+        if len(self.held) < len(self.names):
+            return None
+        
+        merged, self.held = self.held, {}
+        times = [timestamp for _, timestamp in merged.values()]
+        skew = max(times) - min(times)
+        self.skews.append(skew)
+        self.sets += 1
+        return merged, skew
+
+class DeviceGroup:
+    """Several meters driven together: broadcast commands, merge their frames
+    by sampling time and track the skew between them"""
+    def __init__(self, ports):
+        self.events = queue.Queue()
+        self.devices = [MeterDevice(f"M{i + 1}", port, self.events) for i, port in enumerate(ports)]
+        self.merger = FrameMerger(device.name for device in self.devices)
+        self.send_spread = 0.0
+    
+    def open(self):
+        try:
+            for device in self.devices:
+                device.open()
+        except Exception:
+            self.close()
+            raise
+    
+    def close(self):
+        for device in self.devices:
+            device.close()
+    
+    def broadcast(self, command):
+        # Write to every port back to back; the spread is the skew the host adds
+        data = command + "\n"
+        start = time.time()
+        for device in self.devices:
+            device.write(data)
+        self.send_spread = time.time() - start
+        return start
+    
+    def trigger(self):
+        """Measure on every device at once; each then prints a REC line (record on)"""
+        return self.broadcast("start measure")
+    
+    def merge(self, device, record, received):
+        # Aligned by sampling time once the device clock is synced
+        return self.merger.add(device.name, record, device.frame_time(record, received))
 
 class LightMeterUI:
     def __init__(self, root):
@@ -19,6 +488,28 @@ class LightMeterUI:
         self.serial = None
         self.serial_thread = None
         self.thread_running = False
+        # Writes come from the Tk thread and the reader's sync pings
+        self.write_lock = threading.Lock()
+        
+        # Device clock to host time, from sync pings on the connection (or in
+        # the session being played back); times REC frames by sampling time
+        self.clock = ClockSync()
+        
+        # Messages from the serial reader thread, drained on the Tk thread
+        self.rx_queue = queue.Queue()
+        
+        # Console lines waiting for the next batched insert
+        self.console_pending = []
+        self.console_flush = None
+        
+        # Frames for the live heatmap, filled by the reader thread (or demo) and
+        # drained by the renderer; the oldest are dropped if rendering falls behind
+        self.heatmap_frames = collections.deque(maxlen=HEATMAP_BUFFER_FRAMES)
+        self.streaming = False
+        
+        # Session recording and playback
+        self.recorder = None
+        self.playback_running = False
         
         # Device settings
         self.iso = 100
@@ -48,6 +539,10 @@ class LightMeterUI:
         
         # Update display initially
         self.update_display()
+        
+        # Start draining serial messages and rendering the heatmap
+        self.process_rx_queue()
+        self.render_heatmap()
 
     def create_frames(self):
         # Main frames
@@ -68,29 +563,110 @@ class LightMeterUI:
         self.display_canvas = tk.Canvas(self.display_frame, bg="#E5E5E5", height=250, bd=2, relief=tk.SUNKEN)
         self.display_canvas.pack(fill=tk.BOTH, expand=True, padx=5, pady=5)
         
-        # Initialize screen elements (will be populated in update_display)
+        # Canvas items for each screen, created once and updated in place;
+        # each item is tagged with its screen so a screen can be shown or hidden at once
         self.screen_elements = {}
+        self.item_options = {}
+        self.shown_screen = None
+        self.redraw_pending = None
+        self.create_screen_items()
         
-        # Debug: light matrix visualization (not visible on e-ink display)
-        self.debug_matrix_frame = ttk.LabelFrame(self.display_frame, text="Light Sensor Matrix (Debug Only)")
-        self.debug_matrix_frame.pack(fill=tk.X, pady=10)
+        # Debug: live heatmap of the sensor matrix (not visible on e-ink display)
+        self.create_heatmap()
+
+    def create_screen_items(self):
+        canvas = self.display_canvas
         
-        self.debug_matrix_canvas = tk.Canvas(self.debug_matrix_frame, bg="white", height=100)
-        self.debug_matrix_canvas.pack(fill=tk.X, expand=True, padx=5, pady=5)
+        # Main screen: title, settings summary, large shutter speed, EV and help text
+        canvas.create_text(400, 30, text="4x5 LIGHTMETER", font=("Arial", 16, "bold"), fill="black", tags="main")
+        self.screen_elements["main"] = {
+            "settings": canvas.create_text(400, 60, font=("Arial", 10), fill="black", tags="main"),
+            "shutter": canvas.create_text(400, 120, font=("Arial", 36, "bold"), fill="black", tags="main"),
+            "ev": canvas.create_text(400, 170, font=("Arial", 14), fill="black", tags="main"),
+        }
+        canvas.create_text(400, 220, text="Long press MEASURE for menu", font=("Arial", 8), fill="gray", tags="main")
         
-        self.light_matrix = []
-        for row in range(5):
-            matrix_row = []
-            for col in range(4):
-                x = 100 + col * 40
-                y = 10 + row * 20
-                rect = self.debug_matrix_canvas.create_rectangle(x, y, x+30, y+15, fill="white", outline="black", tags=f"led_{row}_{col}")
-                matrix_row.append(rect)
-            self.light_matrix.append(matrix_row)
-            
-        # Highlight spot meter LEDs
-        self.debug_matrix_canvas.create_text(10, 50, text="Spot LEDs:", anchor="w")
-        self.debug_matrix_canvas.create_text(70, 50, text="10, 11", anchor="w", fill="red")
+        # Menu screen: the highlight bar is drawn first so it sits behind the option text
+        canvas.create_text(400, 30, text="MENU", font=("Arial", 16, "bold"), fill="black", tags="menu")
+        self.screen_elements["menu"] = {
+            "highlight": canvas.create_rectangle(0, 0, 0, 0, fill="black", outline="black", tags="menu"),
+            "options": [canvas.create_text(400, 80 + i * 40, text=option, tags="menu")
+                        for i, option in enumerate(self.menu_options)],
+        }
+        canvas.create_text(400, 220, text="UP/DOWN to navigate, MEASURE to select", font=("Arial", 8), fill="gray", tags="menu")
+        
+        # Config screens share one layout
+        self.screen_elements["config"] = {
+            "title": canvas.create_text(400, 30, font=("Arial", 16, "bold"), fill="black", tags="config"),
+            "value": canvas.create_text(400, 120, font=("Arial", 24, "bold"), fill="black", tags="config"),
+        }
+        canvas.create_text(400, 180, text="UP/DOWN to change value", font=("Arial", 10), fill="gray", tags="config")
+        canvas.create_text(400, 210, text="MEASURE to save and return", font=("Arial", 10), fill="gray", tags="config")
+        
+        # Nothing is shown until the first redraw picks a screen
+        for name in self.screen_elements:
+            canvas.itemconfig(name, state=tk.HIDDEN)
+
+    def create_heatmap(self):
+        heatmap_frame_widget = ttk.LabelFrame(self.display_frame, text="Live Sensor Heatmap (Debug Only)")
+        heatmap_frame_widget.pack(fill=tk.X, pady=10)
+        
+        controls = ttk.Frame(heatmap_frame_widget)
+        controls.pack(fill=tk.X, padx=5)
+        self.stream_btn = ttk.Button(controls, text="Stream", command=self.toggle_stream)
+        self.stream_btn.pack(side=tk.LEFT)
+        self.interpolate = tk.BooleanVar(value=False)
+        ttk.Checkbutton(controls, text="Interpolate", variable=self.interpolate,
+                        command=self.heatmap_view_changed).pack(side=tk.LEFT, padx=10)
+        self.heatmap_status = ttk.Label(controls, text="No frames")
+        self.heatmap_status.pack(side=tk.LEFT, padx=10)
+        
+        self.heatmap_canvas = tk.Canvas(heatmap_frame_widget, bg="white", height=140)
+        self.heatmap_canvas.pack(fill=tk.X, expand=True, padx=5, pady=5)
+        canvas = self.heatmap_canvas
+        
+        # Interpolated sub-cells sit underneath the pixel cells, hidden unless enabled
+        self.cell_w, self.cell_h = 60, 24
+        self.heatmap_origin = (20, 10)
+        x0, y0 = self.heatmap_origin
+        steps = HEATMAP_INTERP_STEPS
+        sub_w, sub_h = self.cell_w / steps, self.cell_h / steps
+        self.interp_cells = []
+        for sub_row in range(FRAME_ROWS * steps):
+            for sub_col in range(FRAME_COLS * steps):
+                x = x0 + sub_col * sub_w
+                y = y0 + sub_row * sub_h
+                self.interp_cells.append(canvas.create_rectangle(x, y, x + sub_w, y + sub_h, width=0,
+                                                                 fill="white", state=tk.HIDDEN, tags="interp"))
+        
+        # One cell and label per pixel, row-major as in the frame
+        self.heatmap_cells = []
+        self.heatmap_labels = []
+        for row in range(FRAME_ROWS):
+            for col in range(FRAME_COLS):
+                x = x0 + col * self.cell_w
+                y = y0 + row * self.cell_h
+                self.heatmap_cells.append(canvas.create_rectangle(x, y, x + self.cell_w, y + self.cell_h,
+                                                                  fill="white", outline="gray40"))
+                self.heatmap_labels.append(canvas.create_text(x + self.cell_w / 2, y + self.cell_h / 2,
+                                                              text="", font=("Arial", 9)))
+        
+        # Zone scale
+        scale_x = x0 + FRAME_COLS * self.cell_w + 40
+        canvas.create_text(scale_x, y0 + 8, text="Zone (V = metered EV, one stop per zone)", anchor="w", font=("Arial", 8))
+        for zone, color in enumerate(ZONE_COLORS):
+            x = scale_x + zone * 26
+            canvas.create_rectangle(x, y0 + 20, x + 24, y0 + 38, fill=color, outline="gray40")
+            canvas.create_text(x + 12, y0 + 48, text=ZONE_NAMES[zone], font=("Arial", 8))
+        canvas.create_text(scale_x, y0 + 70, text="SAT = saturated (red border), LOW = below 10 lux",
+                           anchor="w", font=("Arial", 8))
+        canvas.create_text(scale_x, y0 + 88, text="Spot pixels: heavy border in spot mode",
+                           anchor="w", font=("Arial", 8))
+        
+        self.heatmap_last = None
+        self.heatmap_received = 0
+        self.heatmap_drawn = 0
+        self.heatmap_stats_time = time.time()
 
     def create_buttons(self):
         # Physical buttons simulation
@@ -157,20 +733,45 @@ class LightMeterUI:
         self.connect_btn = ttk.Button(serial_frame, text="Connect", command=self.toggle_connection)
         self.connect_btn.pack(side=tk.LEFT, padx=5, pady=5)
         
+        # Session recording and playback
+        self.record_btn = ttk.Button(serial_frame, text="Record Session", command=self.toggle_recording)
+        self.record_btn.pack(side=tk.LEFT, padx=5, pady=5)
+        self.play_btn = ttk.Button(serial_frame, text="Play", command=lambda: self.toggle_playback(True))
+        self.play_btn.pack(side=tk.LEFT, padx=5, pady=5)
+        self.play_fast_btn = ttk.Button(serial_frame, text="Play Fast", command=lambda: self.toggle_playback(False))
+        self.play_fast_btn.pack(side=tk.LEFT, padx=5, pady=5)
+        
+        # Several meters at once
+        devices_btn = ttk.Button(serial_frame, text="Devices...", command=self.open_rig)
+        devices_btn.pack(side=tk.LEFT, padx=5, pady=5)
+        self.rig = None
+        
         # Populate ports
         self.refresh_ports()
 
     def refresh_ports(self):
         ports = [p.device for p in serial.tools.list_ports.comports()]
+        # Emulated meters from the host build (lightmeter_host --pty /tmp/lightmeter...)
+        ports += sorted(glob.glob('/tmp/lightmeter*'))
         self.port_combo['values'] = ports
         if ports:
             self.port_combo.current(0)
 
+    def open_rig(self):
+        if self.rig is None or not self.rig.window.winfo_exists():
+            self.rig = RigWindow(self.root, self.port_combo['values'], self.log)
+        self.rig.window.lift()
+
     def toggle_connection(self):
+        if self.playback_running:
+            self.log("Stop playback before connecting")
+            return
         if self.serial is None:
             try:
                 port = self.port_combo.get()
-                self.serial = serial.Serial(port, 115200, timeout=1)
+                # Short timeout: reads return as soon as bytes arrive, and the
+                # reader notices a disconnect within SERIAL_READ_TIMEOUT
+                self.serial = serial.Serial(port, 115200, timeout=SERIAL_READ_TIMEOUT)
                 self.connect_btn.config(text="Disconnect")
                 self.log("Connected to " + port)
                 
@@ -197,23 +798,192 @@ class LightMeterUI:
             self.log("Disconnected")
 
     def read_serial(self):
-        while self.thread_running and self.serial:
+        # Block until bytes arrive (or the short timeout expires), then take
+        # everything already buffered and split complete lines off the framing buffer.
+        # Sync pings go out from here too, as for rig devices
+        port = self.serial
+        buffer = bytearray()
+        self.rx_calibration = None
+        self.clock = ClockSync()
+        while self.thread_running:
+            if self.clock.due(time.time()):
+                try:
+                    self.transmit(f"sync {self.clock.ping(time.time())}\n")
+                except Exception:
+                    pass
+            
             try:
-                if self.serial.in_waiting:
-                    data = self.serial.readline().decode('utf-8', errors='replace')
-                    self.log(data.strip())
-                    self.parse_response(data)
-                else:
-                    time.sleep(0.1)
+                data = port.read(port.in_waiting or 1)
             except Exception as e:
-                self.log(f"Serial error: {str(e)}")
+                self.rx_queue.put(("error", f"Serial error: {str(e)}"))
                 break
+            
+            if data:
+                # Everything in this chunk arrived by now; the closest host time we have
+                received = time.time()
+                recorder = self.recorder
+                if recorder:
+                    recorder.write(data)
+                buffer.extend(data)
+                self.frame_lines(buffer, received)
         
-        # Clean up on thread exit
+        # Let the Tk thread clean up (tagged with the port, so a stale message
+        # cannot close a later connection)
+        self.rx_queue.put(("closed", port))
+
+    def transmit(self, text):
+        # Every write to the device goes through here so sessions record it,
+        # sync pings included so playback can rebuild the clock mapping
+        data = text.encode('utf-8')
+        with self.write_lock:
+            self.serial.write(data)
+            recorder = self.recorder
+            if recorder:
+                recorder.write(data, sent=True)
+
+    def toggle_recording(self):
+        if self.recorder is None:
+            path = filedialog.asksaveasfilename(defaultextension=".lms",
+                                                filetypes=[("Light meter session", "*.lms"), ("All files", "*")])
+            if not path:
+                return
+            try:
+                self.recorder = SessionRecorder(path)
+            except OSError as e:
+                self.log(f"Error recording session: {str(e)}")
+                return
+            self.record_btn.config(text="Stop Recording")
+            self.log("Recording session to " + path)
+        else:
+            recorder, self.recorder = self.recorder, None
+            recorder.close()
+            self.record_btn.config(text="Record Session")
+            self.log(f"Session recording stopped ({recorder.bytes} bytes)")
+
+    def toggle_playback(self, realtime):
+        if self.playback_running:
+            self.playback_running = False
+            return
         if self.serial:
-            self.serial.close()
-            self.serial = None
-        self.root.after(0, lambda: self.connect_btn.config(text="Connect"))
+            self.log("Disconnect before playing a session")
+            return
+        
+        path = filedialog.askopenfilename(filetypes=[("Light meter session", "*.lms"), ("All files", "*")])
+        if not path:
+            return
+        self.playback_running = True
+        self.play_btn.config(text="Stop")
+        self.play_fast_btn.config(text="Stop")
+        self.log(f"Playing {path} ({'real time' if realtime else 'full speed'})")
+        threading.Thread(target=self.play_session, args=(path, realtime), daemon=True).start()
+
+    def play_session(self, path, realtime):
+        # Replays received bytes through the same framing and parsing as read_serial,
+        # paced by the recorded timestamps or as fast as they can be parsed. Frames
+        # are timed on the recording's own clock, from the sync exchange it holds
+        buffer = bytearray()
+        self.rx_calibration = None
+        self.clock = ClockSync()
+        start = time.monotonic()
+        elapsed_us = 0
+        received = 0
+        try:
+            for delta_us, sent, data in read_session(path):
+                if not self.playback_running:
+                    break
+                elapsed_us += delta_us
+                
+                # Sleep in short slices so Stop stays responsive across long gaps
+                while realtime and self.playback_running:
+                    wait = start + elapsed_us / 1e6 - time.monotonic()
+                    if wait <= 0:
+                        break
+                    time.sleep(min(wait, 0.1))
+                
+                session_time = elapsed_us / 1e6
+                if sent:
+                    text = data.decode('utf-8', errors='replace').strip()
+                    if text.startswith("sync "):
+                        try:
+                            self.clock.expect(int(text[5:]), session_time)
+                        except ValueError:
+                            pass
+                    else:
+                        self.rx_queue.put(("line", "> " + text))
+                else:
+                    received += len(data)
+                    buffer.extend(data)
+                    self.frame_lines(buffer, session_time)
+        except (OSError, ValueError) as e:
+            self.rx_queue.put(("error", f"Playback error: {str(e)}"))
+        
+        duration = time.monotonic() - start
+        self.rx_queue.put(("line", f"Playback finished: {received} bytes of {elapsed_us / 1e6:.1f} s "
+                                   f"session in {duration:.2f} s"))
+        self.rx_queue.put(("playback_done", None))
+
+    def frame_lines(self, buffer, received):
+        # Queue every complete line in the buffer, keeping any partial line;
+        # received is the host time the latest bytes arrived
+        for line in split_lines(buffer):
+            # Sync replies and the console's echo of pings stay out of the log
+            body = line
+            while body.startswith("> "):
+                body = body[2:]
+            if body.startswith("SYNC,"):
+                fields = body.split(",")
+                try:
+                    self.clock.reply(int(fields[1]), int(fields[2]), received)
+                except (ValueError, IndexError):
+                    pass
+                if body != line:
+                    self.rx_queue.put(("line", "> "))
+                continue
+            if body.startswith("sync "):
+                continue
+            
+            self.rx_queue.put(("line", line))
+            
+            # Parse here rather than on the Tk thread; only results cross over
+            updates = parse_response(line)
+            if updates:
+                self.rx_queue.put(("reading", updates))
+            elif line.startswith("CAL,"):
+                self.rx_calibration = parse_calibration(line) or self.rx_calibration
+            elif "REC," in line:
+                record = parse_record(line)
+                if record:
+                    sampled = self.clock.to_host(record["time_us"])
+                    self.heatmap_frames.append(frame_from_record(record, self.rx_calibration,
+                                                                 sampled if sampled is not None else received))
+
+    def process_rx_queue(self):
+        # Runs on the Tk thread: apply everything the reader has queued
+        try:
+            while True:
+                kind, payload = self.rx_queue.get_nowait()
+                if kind == "line":
+                    self.log(payload)
+                elif kind == "reading":
+                    self.apply_reading(payload)
+                elif kind == "playback_done":
+                    self.playback_running = False
+                    self.play_btn.config(text="Play")
+                    self.play_fast_btn.config(text="Play Fast")
+                elif kind == "error":
+                    self.log(payload)
+                elif kind == "closed" and payload is self.serial and self.thread_running:
+                    # Reader stopped on its own (device unplugged or read error)
+                    self.thread_running = False
+                    if self.serial:
+                        self.serial.close()
+                        self.serial = None
+                    self.connect_btn.config(text="Connect")
+                    self.log("Disconnected")
+        except queue.Empty:
+            pass
+        
+        self.root.after(RX_POLL_MS, self.process_rx_queue)
 
     def send_command(self, event):
         cmd = self.cmd_entry.get().strip()
@@ -225,7 +995,7 @@ class LightMeterUI:
         
         if self.serial and self.serial.is_open:
             try:
-                self.serial.write((cmd + '\r\n').encode('utf-8'))
+                self.transmit(cmd + '\r\n')
             except Exception as e:
                 self.log(f"Error sending command: {str(e)}")
         else:
@@ -456,7 +1226,7 @@ reset - Reset device
         """Send configuration command to ESP32 or process in demo mode"""
         if self.serial and self.serial.is_open:
             try:
-                self.serial.write((cmd + '\r\n').encode('utf-8'))
+                self.transmit(cmd + '\r\n')
                 self.log(f"> {cmd}")
             except Exception as e:
                 self.log(f"Error sending command: {str(e)}")
@@ -471,7 +1241,7 @@ reset - Reset device
             
         if self.serial and self.serial.is_open:
             try:
-                self.serial.write("start measure\r\n".encode('utf-8'))
+                self.transmit("start measure\r\n")
                 self.log("> start measure")
             except Exception as e:
                 self.log(f"Error sending command: {str(e)}")
@@ -519,8 +1289,9 @@ reset - Reset device
                 avg_lux = (self.light_values[2][1] + self.light_values[2][2]) / 2
                 
             elif self.metering_type == "highlight":
-                # Highlight metering (brightest patch)
-                avg_lux = max([max(row) for row in self.light_values])
+                # Highlight metering (average of the 5 brightest sensors, as light_meter.c)
+                brightest = sorted([val for row in self.light_values for val in row], reverse=True)[:5]
+                avg_lux = sum(brightest) / len(brightest)
             
             # NEW EV formula: EV = log₂((Lux × ISO) / (K × 100))
             ev = max(-6.0, min(20.0, round(math.log2((avg_lux * self.iso) / (self.k_value * 100.0)), 1)))
@@ -564,8 +1335,22 @@ reset - Reset device
             self.update_light_matrix()
 
     def update_display(self):
-        # Clear canvas
-        self.display_canvas.delete("all")
+        # Coalesce updates: state changes only mark the display dirty, and the
+        # canvas is brought up to date once when Tk next goes idle
+        if self.redraw_pending is None:
+            self.redraw_pending = self.root.after_idle(self.redraw_display)
+
+    def redraw_display(self):
+        self.redraw_pending = None
+        
+        # Show only the current screen's items
+        screen = self.current_screen
+        if screen.startswith("config_"):
+            screen = "config"
+        if screen != self.shown_screen:
+            for name in self.screen_elements:
+                self.display_canvas.itemconfig(name, state=tk.NORMAL if name == screen else tk.HIDDEN)
+            self.shown_screen = screen
         
         # Draw based on current screen
         if self.current_screen == "main":
@@ -579,124 +1364,189 @@ reset - Reset device
         elif self.current_screen == "config_k_value":
             self.draw_config_screen("K Value", f"{self.k_value}")
 
+    def set_item(self, item, canvas=None, **options):
+        # itemconfig only what changed, so an unchanged value costs no canvas repaint
+        canvas = canvas or self.display_canvas
+        cache = self.item_options.setdefault((str(canvas), item), {})
+        changed = {key: value for key, value in options.items() if cache.get(key) != value}
+        if changed:
+            canvas.itemconfig(item, **changed)
+            cache.update(changed)
+
     def draw_main_screen(self):
-        # Title
-        self.display_canvas.create_text(400, 30, text="4x5 LIGHTMETER", font=("Arial", 16, "bold"), fill="black")
+        items = self.screen_elements["main"]
         
         # Settings summary
-        self.display_canvas.create_text(400, 60, text=f"ISO {self.iso} | {self.metering_type.capitalize()} | K {self.k_value}", 
-                                         font=("Arial", 10), fill="black")
-        
-        # Shutter speed (large center display)
-        self.display_canvas.create_text(400, 120, text=self.shutter_speed, 
-                                        font=("Arial", 36, "bold"), fill="black")
-        
-        # EV value
-        self.display_canvas.create_text(400, 170, text=f"EV: {self.ev_value}", 
-                                       font=("Arial", 14), fill="black")
+        self.set_item(items["settings"], text=f"ISO {self.iso} | {self.metering_type.capitalize()} | K {self.k_value}")
         
-        # Help text
-        self.display_canvas.create_text(400, 220, text="Long press MEASURE for menu", 
-                                       font=("Arial", 8), fill="gray")
+        # Shutter speed and EV value
+        self.set_item(items["shutter"], text=self.shutter_speed)
+        self.set_item(items["ev"], text=f"EV: {self.ev_value}")
 
     def draw_menu_screen(self):
-        # Title
-        self.display_canvas.create_text(400, 30, text="MENU", font=("Arial", 16, "bold"), fill="black")
+        items = self.screen_elements["menu"]
         
-        # Draw menu options
-        y_start = 80
-        for i, option in enumerate(self.menu_options):
-            # Highlight selected option
+        # Move the highlight bar behind the selected option
+        y = 80 + self.menu_index * 40
+        self.display_canvas.coords(items["highlight"], 250, y-15, 550, y+15)
+        
+        for i, option_item in enumerate(items["options"]):
             if i == self.menu_index:
-                # Selected option
-                self.display_canvas.create_rectangle(250, y_start-15, 550, y_start+15, 
-                                                     fill="black", outline="black")
-                self.display_canvas.create_text(400, y_start, text=option, 
-                                               font=("Arial", 14, "bold"), fill="white")
+                self.set_item(option_item, font=("Arial", 14, "bold"), fill="white")
             else:
-                # Normal option
-                self.display_canvas.create_text(400, y_start, text=option, 
-                                               font=("Arial", 14), fill="black")
-            y_start += 40
-        
-        # Help text
-        self.display_canvas.create_text(400, 220, text="UP/DOWN to navigate, MEASURE to select", 
-                                       font=("Arial", 8), fill="gray")
+                self.set_item(option_item, font=("Arial", 14), fill="black")
 
     def draw_config_screen(self, setting_name, current_value):
-        # Title
-        self.display_canvas.create_text(400, 30, text=f"Config: {setting_name}", 
-                                        font=("Arial", 16, "bold"), fill="black")
-        
-        # Current value (large center display)
-        self.display_canvas.create_text(400, 120, text=current_value, 
-                                        font=("Arial", 24, "bold"), fill="black")
+        items = self.screen_elements["config"]
         
-        # Help text
-        self.display_canvas.create_text(400, 180, text="UP/DOWN to change value", 
-                                       font=("Arial", 10), fill="gray")
-        self.display_canvas.create_text(400, 210, text="MEASURE to save and return", 
-                                       font=("Arial", 10), fill="gray")
+        self.set_item(items["title"], text=f"Config: {setting_name}")
+        self.set_item(items["value"], text=current_value)
 
     def update_light_matrix(self):
-        # Update debug light matrix visualization
-        if not hasattr(self, 'light_matrix') or not self.light_matrix:
+        # Queue the demo light values as a heatmap frame
+        try:
+            ev = float(self.ev_value)
+        except ValueError:
+            ev = None
+        
+        # Demo EV includes ISO: log2((lux * ISO) / (K * 100))
+        k_value = self.k_value if self.k_value > 0 else 1e-6
+        ev_of_lux = lambda lux: math.log2((lux * self.iso) / (k_value * 100.0))
+        lux_values = [lux for row in self.light_values for lux in row]
+        if ev is None:
+            ev = ev_of_lux(sum(lux_values) / len(lux_values))
+        
+        self.heatmap_frames.append(heatmap_frame(lux_values, ev, ev_of_lux,
+                                                 [lux * 2 >= ADC_SATURATION_CODE for lux in lux_values]))
+
+    def toggle_stream(self):
+        self.streaming = not self.streaming
+        self.stream_btn.config(text="Stop" if self.streaming else "Stream")
+        self.send_config_command("stream on" if self.streaming else "stream off")
+        if self.streaming and not (self.serial and self.serial.is_open):
+            self.demo_stream()
+
+    def demo_stream(self):
+        # Without a device, drift the demo values and stream them at the device's default rate
+        if not self.streaming or (self.serial and self.serial.is_open):
             return
+        for row in self.light_values:
+            for col in range(len(row)):
+                row[col] = max(1.0, row[col] * random.uniform(0.9, 1.1))
+        self.update_light_matrix()
+        self.root.after(HEATMAP_FRAME_MS, self.demo_stream)
+
+    def heatmap_view_changed(self):
+        self.heatmap_canvas.itemconfig("interp", state=tk.NORMAL if self.interpolate.get() else tk.HIDDEN)
+        if self.heatmap_last:
+            self.draw_heatmap(self.heatmap_last)
+
+    def render_heatmap(self):
+        # Take everything buffered since the last tick and draw only the newest
+        frame = None
+        while True:
+            try:
+                frame = self.heatmap_frames.popleft()
+            except IndexError:
+                break
+            self.heatmap_received += 1
+        
+        if frame is not None:
+            self.draw_heatmap(frame)
+            self.heatmap_drawn += 1
+        
+        # Received vs drawn rates, once a second
+        now = time.time()
+        if now - self.heatmap_stats_time >= 1.0:
+            elapsed = now - self.heatmap_stats_time
+            if self.heatmap_received:
+                # Device frames are timed by sampling once the clock sync answers
+                timing = ""
+                if self.heatmap_last and self.heatmap_last.get("sampled") is not None:
+                    timing = (f", sampling time ±{self.clock.error * 1000:.2f} ms" if self.clock.synced
+                              else ", arrival time")
+                self.heatmap_status.config(text=f"{self.heatmap_received / elapsed:.1f} frames/s in, "
+                                                f"{self.heatmap_drawn / elapsed:.1f} drawn{timing}")
+            self.heatmap_received = self.heatmap_drawn = 0
+            self.heatmap_stats_time = now
+        
+        self.root.after(HEATMAP_FRAME_MS, self.render_heatmap)
+
+    def draw_heatmap(self, frame):
+        self.heatmap_last = frame
+        canvas = self.heatmap_canvas
+        interpolate = self.interpolate.get()
+        
+        # Zone of each pixel relative to the metered EV; unreliable pixels fall to zone 0
+        zones = [0.0 if ev is None else min(10.0, max(0.0, 5.0 + ev - frame["ev"]))
+                 for ev in frame["pixel_ev"]]
+        
+        for i, item in enumerate(self.heatmap_cells):
+            row, col = divmod(i, FRAME_COLS)
+            ev = frame["pixel_ev"][i]
             
-        max_lux = max([max(row) for row in self.light_values])
+            if frame["saturated"][i]:
+                label, outline, width = "SAT", "red", 3
+            else:
+                label = "LOW" if ev is None else f"{ev:.1f}"
+                outline, width = "gray40", 1
+                if self.metering_type == "spot" and row == 2 and col in (1, 2):
+                    outline, width = "black", 3
+            
+            fill = "" if interpolate else ZONE_COLORS[int(round(zones[i]))]
+            self.set_item(item, canvas=canvas, fill=fill, outline=outline, width=width)
+            self.set_item(self.heatmap_labels[i], canvas=canvas, text=label,
+                          fill="black" if 3 < zones[i] < 9.5 else "white")
         
-        for row in range(5):
-            for col in range(4):
-                lux = self.light_values[row][col]
-                # Calculate grayscale color (brighter = more light)
-                intensity = int(220 - min(220, (lux / max_lux) * 220))
-                color = f"#{intensity:02x}{intensity:02x}{intensity:02x}"
-                
-                # Highlight spots used by current metering mode
-                if (self.metering_type == "spot" and row == 2 and (col == 1 or col == 2)):
-                    # Highlight spot meter LEDs (10 and 11)
-                    border_color = "red"
-                    border_width = 2
-                else:
-                    border_color = "black"
-                    border_width = 1
-                
-                self.debug_matrix_canvas.itemconfig(self.light_matrix[row][col], 
-                                                   fill=color, 
-                                                   outline=border_color,
-                                                   width=border_width)
+        if interpolate:
+            self.draw_interpolated(zones)
+
+    def draw_interpolated(self, zones):
+        # Bilinear interpolation of zone values between pixel centres
+        steps = HEATMAP_INTERP_STEPS
+        for sub_row in range(FRAME_ROWS * steps):
+            y = min(FRAME_ROWS - 1.0, max(0.0, (sub_row + 0.5) / steps - 0.5))
+            row = min(int(y), FRAME_ROWS - 2)
+            fy = y - row
+            for sub_col in range(FRAME_COLS * steps):
+                x = min(FRAME_COLS - 1.0, max(0.0, (sub_col + 0.5) / steps - 0.5))
+                col = min(int(x), FRAME_COLS - 2)
+                fx = x - col
+                top = zones[row * FRAME_COLS + col] * (1 - fx) + zones[row * FRAME_COLS + col + 1] * fx
+                bottom = zones[(row + 1) * FRAME_COLS + col] * (1 - fx) + zones[(row + 1) * FRAME_COLS + col + 1] * fx
+                zone = top * (1 - fy) + bottom * fy
+                self.set_item(self.interp_cells[sub_row * FRAME_COLS * steps + sub_col], canvas=self.heatmap_canvas,
+                              fill=ZONE_COLORS[int(round(zone))])
 
     def log(self, text):
-        self.console.insert(tk.END, text + "\n")
-        self.console.see(tk.END)
+        # Tk thread only; the serial reader posts its lines through rx_queue.
+        # Lines are batched and inserted once per frame rather than one by one
+        self.console_pending.append(text)
+        if self.console_flush is None:
+            self.console_flush = self.root.after(CONSOLE_FLUSH_MS, self.flush_console)
+
+    def flush_console(self):
+        self.console_flush = None
         
-        # Parse any measurement data
-        self.parse_response(text)
+        # Only the newest CONSOLE_MAX_LINES can survive the trim, so skip the rest
+        text = "\n".join(self.console_pending[-CONSOLE_MAX_LINES:]) + "\n"
+        self.console_pending.clear()
+        self.console.insert(tk.END, text)
+        
+        # Drop the oldest lines beyond the limit (the Text widget always ends
+        # with an empty line after the last newline)
+        lines = int(self.console.index("end-1c").split(".")[0]) - 1
+        if lines > CONSOLE_MAX_LINES:
+            self.console.delete("1.0", f"{lines - CONSOLE_MAX_LINES + 1}.0")
+        self.console.see(tk.END)
 
-    def parse_response(self, text):
-        # Extract shutter speed and EV
-        shutter_match = re.search(r'ISO (\d+), ([\d/\.]+)\s*(?:seconds)?\s*\(EV: ([\d\.]+)\)', text)
-        if shutter_match:
-            iso = int(shutter_match.group(1))
-            shutter = shutter_match.group(2)
-            ev = shutter_match.group(3)
-            
-            self.iso = iso
-            self.shutter_speed = shutter
-            self.ev_value = ev
-            self.update_display()
+    def apply_reading(self, updates):
+        # Settings parsed from device output by the reader thread
+        for name, value in updates.items():
+            setattr(self, name, value)
         
-        # Extract metering mode
-        mode_match = re.search(r'Metering mode: (\w+)', text)
-        if mode_match:
-            self.metering_type = mode_match.group(1).lower()
-            self.update_display()
-            
-        # Extract K value
-        k_match = re.search(r'K value: ([\d\.]+)', text)
-        if k_match:
-            self.k_value = float(k_match.group(1))
-            self.update_display()
+        # One redraw for the whole line
+        self.update_display()
 
     def toggle_demo_mode(self):
         self.demo_mode = not self.demo_mode
@@ -718,8 +1568,349 @@ reset - Reset device
         
         self.simulate_measurement()
 
+class RigWindow:
+    """Window driving several meters as one rig: connect, trigger and stream
+    them together, with their latest frames side by side and the skew between them"""
+    def __init__(self, root, ports, log):
+        self.root = root
+        self.log = log
+        self.group = None
+        self.streaming = False
+        self.merged_ev = None
+        
+        self.window = tk.Toplevel(root)
+        self.window.title("Devices")
+        self.window.protocol("WM_DELETE_WINDOW", self.close)
+        
+        ttk.Label(self.window, text="Ports (select several):").pack(anchor=tk.W, padx=10, pady=(10, 0))
+        self.port_list = tk.Listbox(self.window, selectmode=tk.MULTIPLE, height=6, exportselection=False)
+        self.port_list.pack(fill=tk.X, padx=10)
+        for port in ports:
+            self.port_list.insert(tk.END, port)
+        
+        controls = ttk.Frame(self.window)
+        controls.pack(fill=tk.X, padx=10, pady=5)
+        self.connect_btn = ttk.Button(controls, text="Connect All", command=self.toggle_connection)
+        self.connect_btn.pack(side=tk.LEFT, padx=5)
+        ttk.Button(controls, text="Trigger All", command=self.trigger).pack(side=tk.LEFT, padx=5)
+        self.stream_btn = ttk.Button(controls, text="Stream All", command=self.toggle_stream)
+        self.stream_btn.pack(side=tk.LEFT, padx=5)
+        
+        columns = ("device", "port", "seq", "ev", "shutter", "offset", "sync")
+        self.table = ttk.Treeview(self.window, columns=columns, show="headings", height=6)
+        for column, heading, width in zip(columns, ("Device", "Port", "Seq", "EV", "Shutter", "Offset (ms)", "Clock Sync"),
+                                          (60, 160, 60, 60, 100, 90, 150)):
+            self.table.heading(column, text=heading)
+            self.table.column(column, width=width, anchor=tk.CENTER)
+        self.table.pack(fill=tk.BOTH, expand=True, padx=10)
+        
+        self.skew_label = ttk.Label(self.window, text="Skew: -")
+        self.skew_label.pack(anchor=tk.W, padx=10)
+        self.merged_label = ttk.Label(self.window, text="No merged frames")
+        self.merged_label.pack(anchor=tk.W, padx=10, pady=(0, 10))
+        
+        self.poll()
+    
+    def toggle_connection(self):
+        if self.group is None:
+            ports = [self.port_list.get(i) for i in self.port_list.curselection()]
+            if not ports:
+                self.log("Select the ports of the rig first")
+                return
+            group = DeviceGroup(ports)
+            try:
+                group.open()
+            except Exception as e:
+                self.log(f"Error connecting rig: {str(e)}")
+                return
+            self.group = group
+            
+            # Every measurement reports a REC line, which is what gets merged
+            self.group.broadcast("record on")
+            for device in self.group.devices:
+                self.table.insert("", tk.END, iid=device.name,
+                                  values=(device.name, device.port, "-", "-", "-", "-", "-"))
+            self.connect_btn.config(text="Disconnect All")
+            self.log(f"Rig connected: {len(ports)} devices")
+        else:
+            self.disconnect()
+    
+    def disconnect(self):
+        if self.group is None:
+            return
+        if self.streaming:
+            self.toggle_stream()
+        self.group.close()
+        self.group = None
+        self.table.delete(*self.table.get_children())
+        self.connect_btn.config(text="Connect All")
+        self.log("Rig disconnected")
+    
+    def trigger(self):
+        if self.group:
+            self.group.trigger()
+            self.log(f"Rig triggered, send spread {self.group.send_spread * 1000:.2f} ms")
+    
+    def toggle_stream(self):
+        if self.group is None:
+            return
+        self.streaming = not self.streaming
+        self.group.broadcast("stream on" if self.streaming else "stream off")
+        self.stream_btn.config(text="Stop Streams" if self.streaming else "Stream All")
+    
+    def poll(self):
+        if not self.window.winfo_exists():
+            return
+        if self.group:
+            self.drain_events()
+        self.window.after(RIG_POLL_MS, self.poll)
+    
+    def drain_events(self):
+        group = self.group
+        updated = None
+        try:
+            while True:
+                event = group.events.get_nowait()
+                kind, device = event[0], event[1]
+                if kind == "record":
+                    merged = group.merge(device, event[2], event[3])
+                    if merged:
+                        updated = merged
+                elif kind == "line":
+                    if event[2] and not event[2].startswith(">"):
+                        self.log(f"[{device.name}] {event[2]}")
+                elif kind == "closed":
+                    self.log(f"[{device.name}] Connection closed")
+        except queue.Empty:
+            pass
+        
+        # Only the newest merged set is shown; older ones still count toward the skew
+        if updated:
+            self.show_merged(*updated)
+    
+    def show_merged(self, merged, skew):
+        earliest = min(timestamp for _, timestamp in merged.values())
+        devices = {device.name: device for device in self.group.devices}
+        for name, (record, timestamp) in merged.items():
+            clock = devices[name].clock
+            sync = f"±{clock.error * 1000:.2f} ms, {clock.drift_ppm:+.0f} ppm" if clock.synced else "receive time"
+            self.table.item(name, values=(name, devices[name].port, record["seq"],
+                                          f"{record['ev']:.2f}", format_shutter(record["ev"]),
+                                          f"{(timestamp - earliest) * 1000:.1f}", sync))
+        
+        # Sampling-time skew when every clock is synced, otherwise arrival skew
+        basis = "sampling" if all(device.clock.synced for device in self.group.devices) else "arrival"
+        skews = self.group.merger.skews
+        self.skew_label.config(text=f"Skew ({basis}): {skew * 1000:.1f} ms (mean {sum(skews) / len(skews) * 1000:.1f}, "
+                                    f"max {max(skews) * 1000:.1f} over {len(skews)} sets)")
+        # Combined reading: the mean EV of the rig
+        mean_ev = sum(record["ev"] for record, _ in merged.values()) / len(merged)
+        self.merged_label.config(text=f"{self.group.merger.sets} merged sets, combined EV {mean_ev:.2f} "
+                                      f"({format_shutter(mean_ev)})")
+    
+    def close(self):
+        self.disconnect()
+        self.window.destroy()
+
+# Headless runs: exit status
+HEADLESS_OK = 0
+HEADLESS_INVALID = 1  # Invalid or missing measurements
+HEADLESS_ERROR = 2    # Connection, script or command failure
+
+def record_problem(record, mv_table):
+    """Why a measurement cannot be trusted, or None if it is valid"""
+    if any(raw >= ADC_SATURATION_CODE for raw in record["raw"]):
+        return "saturated"
+    frame = frame_from_record(record, mv_table)
+    if all(pixel_ev is None for pixel_ev in frame["pixel_ev"]):
+        return "dark"
+    return None
+
+class HeadlessRun:
+    """Scripted measurement run without the GUI: configure the meter, take or
+    stream N measurements and write them as CSV"""
+    def __init__(self, args):
+        self.args = args
+        self.events = queue.Queue()
+        self.device = MeterDevice("M1", args.port, self.events)
+        self.output = None
+        self.records = 0
+        self.problems = collections.Counter()
+        self.missing = 0
+        self.last_seq = None
+    
+    def note(self, text):
+        if not self.args.quiet:
+            print(text, file=sys.stderr)
+    
+    def next_event(self, deadline):
+        """Next event from the device, None at the deadline
+        Console output is passed to stderr; a closed port is an error"""
+        while True:
+            remaining = deadline - time.time()
+            if remaining <= 0:
+                return None
+            try:
+                event = self.events.get(timeout=remaining)
+            except queue.Empty:
+                return None
+            if event[0] == "closed":
+                raise ConnectionError("serial port closed")
+            if event[0] == "line" and event[2]:
+                self.note(event[2])
+            return event
+    
+    def command(self, text):
+        """Send one command and wait for its prompt; False if the device rejects it"""
+        self.device.write(text + "\n")
+        deadline = time.time() + self.args.timeout
+        rejected = False
+        while True:
+            event = self.next_event(deadline)
+            if event is None:
+                raise TimeoutError(f"no prompt after '{text}'")
+            if event[0] == "line" and event[2].startswith(("Error", "Unknown command")):
+                rejected = True
+            elif event[0] == "record":
+                self.write_record(event[2])
+            elif event[0] == "prompt":
+                return not rejected
+    
+    def write_record(self, record):
+        if self.last_seq is not None and record["seq"] > self.last_seq + 1:
+            self.missing += record["seq"] - self.last_seq - 1
+        self.last_seq = record["seq"]
+        self.records += 1
+        
+        problem = record_problem(record, self.device.calibration)
+        if problem:
+            self.problems[problem] += 1
+        # Sampling time on the host clock, empty until the clock sync answers
+        host_time = self.device.clock.to_host(record["time_us"])
+        host_field = "" if host_time is None else f"{host_time:.6f}"
+        self.output.write(f"{record['seq']},{record['time_us']},{host_field},{record['iso']},{record['mode']},"
+                          f"{record['k_value']},{record['ev']},{format_shutter(record['ev'])},"
+                          f"{problem or 'ok'},{','.join(map(str, record['raw']))}\n")
+    
+    def measure(self, count):
+        # One trigger at a time; its REC line arrives before the report's prompt
+        for _ in range(count):
+            before = self.records
+            self.device.write("start measure\n")
+            deadline = time.time() + self.args.timeout
+            while True:
+                event = self.next_event(deadline)
+                if event is None:
+                    self.note("Measurement timed out")
+                    return
+                if event[0] == "record":
+                    self.write_record(event[2])
+                elif event[0] == "prompt" and self.records > before:
+                    break
+    
+    def stream(self, count):
+        interval = f" {self.args.interval}" if self.args.interval else ""
+        self.device.write(f"stream on{interval}\n")
+        # Frames keep coming, so the time limit applies per frame
+        target = self.records + count
+        deadline = time.time() + self.args.timeout
+        while self.records < target:
+            event = self.next_event(deadline)
+            if event is None:
+                self.note("Stream timed out")
+                break
+            if event[0] == "record":
+                self.write_record(event[2])
+                deadline = time.time() + self.args.timeout
+        self.device.write("stream off\n")
+        
+        # Frames already on the way before the stop count too
+        deadline = time.time() + self.args.timeout
+        while True:
+            event = self.next_event(deadline)
+            if event is None or event[0] == "prompt":
+                break
+    
+    def run(self):
+        args = self.args
+        try:
+            self.device.open()
+        except Exception as e:
+            print(f"Error connecting: {str(e)}", file=sys.stderr)
+            return HEADLESS_ERROR
+        
+        try:
+            self.output = open(args.csv, "w") if args.csv != "-" else sys.stdout
+            self.output.write("seq,time_us,host_time,iso,mode,k_value,ev,shutter,status,"
+                              + ",".join(f"raw_{i}" for i in range(1, FRAME_ROWS * FRAME_COLS + 1)) + "\n")
+            
+            # Records must be text REC lines, reported for triggered measurements too
+            setup = ["config output text", "record on"]
+            if args.script:
+                with open(args.script) as script:
+                    setup += [line.strip() for line in script
+                              if line.strip() and not line.lstrip().startswith("#")]
+            for command in setup:
+                if not self.command(command):
+                    print(f"Error: command failed: {command}", file=sys.stderr)
+                    return HEADLESS_ERROR
+            
+            # Let the clock sync's first burst of pings complete
+            deadline = time.time() + args.timeout
+            while len(self.device.clock.samples) < SYNC_BURST and time.time() < deadline:
+                self.next_event(min(deadline, time.time() + SYNC_BURST_INTERVAL_S))
+            
+            start = time.time()
+            if args.stream:
+                self.stream(args.stream)
+            else:
+                self.measure(args.measure)
+            elapsed = time.time() - start
+        except (OSError, ConnectionError, TimeoutError) as e:
+            print(f"Error: {str(e)}", file=sys.stderr)
+            return HEADLESS_ERROR
+        finally:
+            if self.output and self.output is not sys.stdout:
+                self.output.close()
+            else:
+                sys.stdout.flush()
+            self.device.close()
+        
+        wanted = args.stream or args.measure
+        invalid = sum(self.problems.values())
+        self.note(f"{self.records} measurements in {elapsed:.2f} s ({self.records / elapsed if elapsed > 0 else 0:.1f}/s), "
+                  f"{invalid} invalid ({', '.join(f'{n} {problem}' for problem, n in self.problems.items()) or 'none'}), "
+                  f"{self.missing} missing by sequence")
+        clock = self.device.clock
+        if clock.synced:
+            self.note(f"Clock sync: ±{clock.error * 1000:.2f} ms, drift {clock.drift_ppm:+.1f} ppm "
+                      f"({len(clock.samples)} pings)")
+        if self.records < wanted or invalid or self.missing:
+            return HEADLESS_INVALID
+        return HEADLESS_OK
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="4x5 light meter UI, or a scripted measurement run with --headless")
+    parser.add_argument("--headless", action="store_true", help="Run without the GUI (needs --port)")
+    parser.add_argument("--port", help="Serial port of the meter")
+    parser.add_argument("--script", help="Commands to send before measuring, one per line (# comments)")
+    count = parser.add_mutually_exclusive_group()
+    count.add_argument("--measure", type=int, default=1, metavar="N", help="Trigger N measurements (default 1)")
+    count.add_argument("--stream", type=int, metavar="N", help="Stream N frames instead")
+    parser.add_argument("--interval", type=int, metavar="MS", help="Stream interval in ms (device default if omitted)")
+    parser.add_argument("--csv", default="-", help="CSV output file (default stdout)")
+    parser.add_argument("--timeout", type=float, default=10.0, help="Seconds to wait for a prompt or a frame")
+    parser.add_argument("--quiet", action="store_true", help="No console output or summary on stderr")
+    args = parser.parse_args()
+    if args.headless and not args.port:
+        parser.error("--headless needs --port")
+    return args
+
 # Start the application
 if __name__ == "__main__":
+    args = parse_args()
+    if args.headless:
+        sys.exit(HeadlessRun(args).run())
     root = tk.Tk()
     app = LightMeterUI(root)
     root.mainloop()
\ No newline at end of file
@@ -5,7 +5,10 @@
 
  #include "adc_reader.h"
  #include "led_control.h"
+ #include "frame_record.h"
+ #include "esp_attr.h"
  #include "esp_log.h"
+ #include "esp_rom_sys.h"
  #include "driver/gpio.h"
  #include "esp_adc/adc_oneshot.h"
  #include "esp_adc/adc_cali.h"
@@ -13,6 +16,7 @@
  #include "freertos/FreeRTOS.h"
  #include "freertos/task.h"
  #include <math.h>
+ #include <string.h>
  
  static const char *TAG = "ADC_READER";
  
@@ -21,6 +25,41 @@
  static adc_cali_handle_t adc1_cali_handle = NULL;
  static bool do_calibration = true;
  
+ // Codes at or above this are past the calibrated range and converted linearly
+ #define ADC_CALI_MAX_CODE    4000
+ 
+ // ADC channel of each row, resolved once at init for the scan loop
+ static adc_channel_t row_channels[FRAME_ROWS];
+ 
+ // Active scan strategy
+ static scan_config_t scan_config = SCAN_CONFIG_DEFAULT;
+ 
+ // Named strategies, selectable from the console and compared by the host scan simulator
+ static const scan_preset_t scan_presets[] = {
+     { "default", SCAN_CONFIG_DEFAULT },
+     { "serial-fast", { .order = SCAN_ORDER_SERIAL, .hold_enable = false,
+                        .mux_settle_us = 50, .enable_settle_us = 200, .pixel_gap_us = 0,
+                        .oversample = 1, .oversample_interval_us = 0 } },
+     { "serial-held", { .order = SCAN_ORDER_SERIAL, .hold_enable = true,
+                        .mux_settle_us = 200, .enable_settle_us = 200, .pixel_gap_us = 0,
+                        .oversample = 1, .oversample_interval_us = 0 } },
+     { "column", { .order = SCAN_ORDER_COLUMN_PARALLEL, .hold_enable = false,
+                   .mux_settle_us = 50, .enable_settle_us = 200, .pixel_gap_us = 0,
+                   .oversample = 1, .oversample_interval_us = 0 } },
+     { "column-held", { .order = SCAN_ORDER_COLUMN_PARALLEL, .hold_enable = true,
+                        .mux_settle_us = 200, .enable_settle_us = 200, .pixel_gap_us = 0,
+                        .oversample = 1, .oversample_interval_us = 0 } },
+     { "column-os4", { .order = SCAN_ORDER_COLUMN_PARALLEL, .hold_enable = true,
+                       .mux_settle_us = 200, .enable_settle_us = 200, .pixel_gap_us = 0,
+                       .oversample = 4, .oversample_interval_us = 0 } },
+     // Four conversions 2.5 ms apart span a full 100 Hz flicker cycle
+     { "column-flicker", { .order = SCAN_ORDER_COLUMN_PARALLEL, .hold_enable = true,
+                           .mux_settle_us = 200, .enable_settle_us = 200, .pixel_gap_us = 0,
+                           .oversample = 4, .oversample_interval_us = 2500 } },
+ };
+ 
+ #define SCAN_PRESET_COUNT    (int)(sizeof(scan_presets) / sizeof(scan_presets[0]))
+ 
  // Mapping from GPIO to ADC channels for ESP32-C3
  // ESP32-C3 only supports ADC1 with channels 0-4
  static adc_channel_t gpio_to_adc_channel(int gpio_num) {
@@ -37,9 +76,6 @@
      }
  }
  
- // Constants for lux conversion
- #define RLOAD_OHM 1300  // 739 + 11 Ohm RDSon (using 750 ohm standard value)
- 
  /**
   * Initialize the ADC reader module
   */
@@ -57,17 +93,16 @@
      };
      
      // Map GPIO pins to ADC channels and configure them
-     adc_channel_t channels[5];
-     channels[0] = gpio_to_adc_channel(ADC_LED14_GPIO);
-     channels[1] = gpio_to_adc_channel(ADC_LED58_GPIO);
-     channels[2] = gpio_to_adc_channel(ADC_LED912_GPIO);
-     channels[3] = gpio_to_adc_channel(ADC_LED1316_GPIO);
-     channels[4] = gpio_to_adc_channel(ADC_LED1720_GPIO);
+     row_channels[0] = gpio_to_adc_channel(ADC_LED14_GPIO);
+     row_channels[1] = gpio_to_adc_channel(ADC_LED58_GPIO);
+     row_channels[2] = gpio_to_adc_channel(ADC_LED912_GPIO);
+     row_channels[3] = gpio_to_adc_channel(ADC_LED1316_GPIO);
+     row_channels[4] = gpio_to_adc_channel(ADC_LED1720_GPIO);
      
      // Configure each ADC channel
      for (int i = 0; i < 5; i++) {
-         ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, channels[i], &config));
-         ESP_LOGI(TAG, "Configured ADC channel %d", channels[i]);
+         ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, row_channels[i], &config));
+         ESP_LOGI(TAG, "Configured ADC channel %d", row_channels[i]);
      }
      
      // Calibration setup
@@ -80,53 +115,86 @@
          ESP_ERROR_CHECK(adc_cali_create_scheme_curve_fitting(&cali_config, &adc1_cali_handle));
      }
      
+     // Cache the calibrated voltage of every ADC code for frame consumers
+     light_frame_init_lut(get_voltage_from_adc);
+     
      ESP_LOGI(TAG, "ADC reader module initialized");
  }
  
+ /**
+  * Wait for a scan settle time
+  * Whole ticks yield to other tasks; the sub-tick rest busy-waits so it is not lost
+  */
+ static void IRAM_ATTR scan_delay_us(uint32_t us) {
+     TickType_t ticks = pdMS_TO_TICKS(us / 1000);
+     uint32_t rest_us = us - ticks * portTICK_PERIOD_MS * 1000;
+     
+     if (ticks > 0) {
+         vTaskDelay(ticks);
+     }
+     if (rest_us > 0) {
+         esp_rom_delay_us(rest_us);
+     }
+ }
+ 
+ /**
+  * Get the ADC channel wired to a row (1-5)
+  */
+ static bool row_to_adc_channel(int row, adc_channel_t *channel) {
+     if (row < 1 || row > FRAME_ROWS) {
+         ESP_LOGE(TAG, "Invalid row for ADC reading: %d", row);
+         return false;
+     }
+     
+     *channel = row_channels[row-1];
+     return true;
+ }
+ 
+ /**
+  * Convert a channel, averaging as many conversions as the scan strategy asks for
+  */
+ static int IRAM_ATTR read_channel(adc_channel_t adc_channel) {
+     int count = scan_config.oversample > 0 ? scan_config.oversample : 1;
+     int sum = 0;
+     
+     for (int i = 0; i < count; i++) {
+         if (i > 0) {
+             scan_delay_us(scan_config.oversample_interval_us);
+         }
+         
+         int adc_raw;
+         ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, adc_channel, &adc_raw));
+         sum += adc_raw;
+     }
+     
+     return (sum + count / 2) / count;
+ }
+ 
  /**
   * Read ADC value for specific LED based on row and column
   */
  int read_adc_for_led(int row, int col) {
+     adc_channel_t adc_channel;
+     
+     // Determine which ADC channel to read based on the row
+     if (!row_to_adc_channel(row, &adc_channel)) {
+         return 0;
+     }
+     
      // Select the proper LED via multiplexers
      select_led(row, col);
      
      // Small delay to allow multiplexer to settle
-     vTaskDelay(pdMS_TO_TICKS(1));
+     scan_delay_us(scan_config.mux_settle_us);
      
      // Enable the measurement circuit
      enable_measurement(true);
      
      // Additional delay for circuit to stabilize
-     vTaskDelay(pdMS_TO_TICKS(10));
-     
-     // Determine which ADC channel to read based on the row
-     // For ESP32-C3 we need to map our GPIO pins to the available channels (0-4)
-     adc_channel_t adc_channel;
-     
-     switch (row) {
-         case 1:
-             adc_channel = gpio_to_adc_channel(ADC_LED14_GPIO);
-             break;
-         case 2:
-             adc_channel = gpio_to_adc_channel(ADC_LED58_GPIO);
-             break;
-         case 3:
-             adc_channel = gpio_to_adc_channel(ADC_LED912_GPIO);
-             break;
-         case 4:
-             adc_channel = gpio_to_adc_channel(ADC_LED1316_GPIO);
-             break;
-         case 5:
-             adc_channel = gpio_to_adc_channel(ADC_LED1720_GPIO);
-             break;
-         default:
-             ESP_LOGE(TAG, "Invalid row for ADC reading: %d", row);
-             return 0;
-     }
+     scan_delay_us(scan_config.enable_settle_us);
      
      // Read ADC value
-     int adc_raw;
-     ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, adc_channel, &adc_raw));
+     int adc_raw = read_channel(adc_channel);
      
      // Disable measurement circuit
      enable_measurement(false);
@@ -140,7 +208,7 @@
   * Get the voltage from an ADC value
   */
  float get_voltage_from_adc(int adc_value) {
-    if (adc1_cali_handle && adc_value < 4000) {
+    if (adc1_cali_handle && adc_value < ADC_CALI_MAX_CODE) {
         // Only use calibration for non-saturated values
         int voltage_mv;
         ESP_ERROR_CHECK(adc_cali_raw_to_voltage(adc1_cali_handle, adc_value, &voltage_mv));
@@ -158,6 +226,28 @@
     }
 }
  
+/**
+ * Get the calibrated voltage in mV for an ADC code
+ */
+static int get_calibrated_mv(int adc_value) {
+    int voltage_mv = 0;
+    ESP_ERROR_CHECK(adc_cali_raw_to_voltage(adc1_cali_handle, adc_value, &voltage_mv));
+    return voltage_mv;
+}
+
+/**
+ * Print the calibration curve as a CAL record so recordings can be replayed
+ * with the exact voltages of this chip
+ */
+void adc_reader_print_calibration(FILE *out) {
+    if (adc1_cali_handle == NULL) {
+        ESP_LOGW(TAG, "No ADC calibration available to record");
+        return;
+    }
+    
+    frame_record_print_calibration(out, get_calibrated_mv, ADC_CALI_MAX_CODE);
+}
+
 /**
  * Convert ADC reading to lux based on the exact formula:
  * Viout = 0.0057 × 10^-6 × Ev × R1
@@ -169,11 +259,8 @@ float convert_to_lux(int adc_value) {
     // Get voltage (Viout)
     float voltage = get_voltage_from_adc(adc_value);
     
-    // Constants from formula
-    float sensitivity = 0.0057e-6f; // 0.0057 × 10^-6
-    
     // Calculate illuminance (lux) directly using the formula
-    float lux = voltage / (sensitivity * RLOAD_OHM);
+    float lux = lux_from_voltage(voltage);
     
     // Log the values for debugging
     ESP_LOGD(TAG, "ADC: %d, Voltage: %.4fV, Lux: %.2f", 
@@ -183,52 +270,157 @@ float convert_to_lux(int adc_value) {
 }
  
  /**
-  * Measure all LEDs and populate the lux matrix
+  * Select a column for the scan and let it settle
+  * With a held enable the circuit stays on and only the multiplexer switches
   */
- void measure_all_leds(float lux_matrix[5][4]) {
-     ESP_LOGI(TAG, "Measuring all LEDs...");
+ static void IRAM_ATTR scan_select(int row, int col) {
+     select_led(row, col);
+     scan_delay_us(scan_config.mux_settle_us);
+     
+     if (!scan_config.hold_enable) {
+         enable_measurement(true);
+         scan_delay_us(scan_config.enable_settle_us);
+     }
+ }
+ 
+ /**
+  * Finish a column of the scan
+  */
+ static void IRAM_ATTR scan_release(void) {
+     if (!scan_config.hold_enable) {
+         enable_measurement(false);
+     }
+     
+     // Short delay between measurements
+     scan_delay_us(scan_config.pixel_gap_us);
+ }
+ 
+ /**
+  * Scan every pixel with the active strategy
+  * The loop, the mux/enable control, the ADC read (CONFIG_ADC_ONESHOT_CTRL_FUNC_IN_IRAM)
+  * and the frame store all run from IRAM, so pixel timing does not depend on
+  * flash cache misses. No logging in here: format strings live in flash.
+  */
+ static void IRAM_ATTR scan_frame(light_frame_t *frame) {
+     if (scan_config.hold_enable) {
+         enable_measurement(true);
+         scan_delay_us(scan_config.enable_settle_us);
+     }
      
-     for (int row = 1; row <= 5; row++) {
-         for (int col = 1; col <= 4; col++) {
-             // Read ADC value
-             int adc_value = read_adc_for_led(row, col);
+     // Note: Frame indices are 0-indexed, but our row/col are 1-indexed
+     if (scan_config.order == SCAN_ORDER_COLUMN_PARALLEL) {
+         // Every row has its own ADC channel behind the same column select
+         for (int col = 1; col <= FRAME_COLS; col++) {
+             int count = scan_config.oversample > 0 ? scan_config.oversample : 1;
+             int sums[FRAME_ROWS] = {0};
+             
+             scan_select(1, col);
              
-             // Convert to lux and store in matrix
-             // Note: Arrays are 0-indexed, but our row/col are 1-indexed
-             lux_matrix[row-1][col-1] = convert_to_lux(adc_value);
+             // Oversampling sweeps all rows per pass, so the passes share one interval
+             for (int i = 0; i < count; i++) {
+                 if (i > 0) {
+                     scan_delay_us(scan_config.oversample_interval_us);
+                 }
+                 
+                 for (int row = 1; row <= FRAME_ROWS; row++) {
+                     int adc_raw;
+                     ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, row_channels[row-1], &adc_raw));
+                     sums[row-1] += adc_raw;
+                 }
+             }
              
-             // Short delay between measurements
-             vTaskDelay(pdMS_TO_TICKS(50));
+             for (int row = 1; row <= FRAME_ROWS; row++) {
+                 int adc_value = (sums[row-1] + count / 2) / count;
+                 light_frame_set_raw(frame, FRAME_INDEX(row-1, col-1), (uint16_t)adc_value);
+             }
+             
+             scan_release();
+         }
+     } else {
+         for (int row = 1; row <= FRAME_ROWS; row++) {
+             for (int col = 1; col <= FRAME_COLS; col++) {
+                 // Read ADC value and store it with its flag bits
+                 scan_select(row, col);
+                 int adc_value = read_channel(row_channels[row-1]);
+                 light_frame_set_raw(frame, FRAME_INDEX(row-1, col-1), (uint16_t)adc_value);
+                 scan_release();
+             }
          }
      }
      
+     if (scan_config.hold_enable) {
+         enable_measurement(false);
+     }
+ }
+ 
+ /**
+  * Measure all LEDs into a compact frame of raw ADC codes
+  * using the active scan strategy
+  */
+ void measure_frame(light_frame_t *frame) {
+     ESP_LOGI(TAG, "Measuring all LEDs...");
+     
+     light_frame_clear(frame);
+     scan_frame(frame);
+     
      ESP_LOGI(TAG, "All LED measurements completed");
  }
  
+ /**
+  * Measure all LEDs and populate the lux matrix
+  */
+ void measure_all_leds(float lux_matrix[5][4]) {
+     light_frame_t frame;
+     measure_frame(&frame);
+     light_frame_to_lux_matrix(&frame, lux_matrix);
+ }
+ 
  /**
   * Measure all LEDs with detailed values including ADC, voltage, and lux
   */
  void measure_all_leds_detailed(led_measurement_t measurements[5][4]) {
-     ESP_LOGI(TAG, "Starting detailed measurements of all LEDs...");
+     light_frame_t frame;
+     measure_frame(&frame);
+     light_frame_to_measurements(&frame, measurements);
+ }
+ 
+ /**
+  * Set the scan strategy used by measure_frame()
+  */
+ void adc_reader_set_scan_config(const scan_config_t *config) {
+     scan_config = *config;
      
-     for (int row = 1; row <= 5; row++) {
-         for (int col = 1; col <= 4; col++) {
-             // Read ADC value
-             int adc_value = read_adc_for_led(row, col);
-             
-             // Store ADC value
-             measurements[row-1][col-1].adc_value = adc_value;
-             
-             // Convert to voltage and store
-             measurements[row-1][col-1].voltage = get_voltage_from_adc(adc_value);
-             
-             // Convert to lux and store
-             measurements[row-1][col-1].lux = convert_to_lux(adc_value);
-             
-             // Short delay between measurements
-             vTaskDelay(pdMS_TO_TICKS(50));
+     ESP_LOGI(TAG, "Scan: %s, enable %s, settle %lu/%lu us, gap %lu us, oversample %u every %lu us",
+              scan_config.order == SCAN_ORDER_COLUMN_PARALLEL ? "column-parallel" : "serial",
+              scan_config.hold_enable ? "held" : "toggled",
+              (unsigned long)scan_config.mux_settle_us, (unsigned long)scan_config.enable_settle_us,
+              (unsigned long)scan_config.pixel_gap_us, (unsigned)scan_config.oversample,
+              (unsigned long)scan_config.oversample_interval_us);
+ }
+ 
+ /**
+  * Get the active scan strategy
+  */
+ void adc_reader_get_scan_config(scan_config_t *config) {
+     *config = scan_config;
+ }
+ 
+ /**
+  * Get the table of named scan strategies
+  */
+ const scan_preset_t *adc_reader_scan_presets(int *count) {
+     *count = SCAN_PRESET_COUNT;
+     return scan_presets;
+ }
+ 
+ /**
+  * Look up a named scan strategy
+  */
+ const scan_preset_t *adc_reader_find_scan_preset(const char *name) {
+     for (int i = 0; i < SCAN_PRESET_COUNT; i++) {
+         if (strcmp(scan_presets[i].name, name) == 0) {
+             return &scan_presets[i];
          }
      }
-     
-     ESP_LOGI(TAG, "All detailed LED measurements completed");
+     return NULL;
  }
\ No newline at end of file
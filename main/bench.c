@@ -0,0 +1,222 @@
+/*
+ * Bench Module for 4x5 Camera Light Meter
+ * Implementation file
+ *
+ * Kernels run on canned frames and report the cycles of the first (cold)
+ * call, taken right after the cache has been flushed by reading a block of
+ * flash data, next to the average warm cycles/op. Code executed from flash
+ * pays cache misses on the cold call; code placed in IRAM does not. Scans
+ * likewise report a cold first frame next to the warm average.
+ */
+
+#include "bench.h"
+#include "adc_reader.h"
+#include "light_frame.h"
+#include "light_meter.h"
+#include "log_quiet.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_memory_utils.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include <stdint.h>
+
+static const char *TAG = "BENCH";
+
+// Flash data read to evict the cache before a cold call (twice the 16 KB cache)
+#define CACHE_EVICT_WORDS   8192
+#define CACHE_LINE_WORDS    8
+static const uint32_t cache_evict_data[CACHE_EVICT_WORDS] = { 1 };
+
+// Warm iterations timed between cycle counter reads (the 32-bit counter wraps in ~27 s)
+#define BENCH_CHUNK         256
+
+// Canned frames covering mid-range, gradient, saturated and low-light pixels
+#define CANNED_FRAMES       4
+static light_frame_t canned[CANNED_FRAMES];
+static float canned_lux[CANNED_FRAMES][5][4];
+static light_frame_t scratch;
+
+// Results are stored here so the kernels are not optimized away
+static volatile float sink;
+
+// A timed kernel; code is the function under test, for its placement
+typedef struct {
+    const char *name;
+    const void *code;
+    void (*run)(int i);
+} bench_kernel_t;
+
+/**
+ * Build the canned frames
+ */
+static void build_canned_frames(void) {
+    for (int f = 0; f < CANNED_FRAMES; f++) {
+        light_frame_clear(&canned[f]);
+
+        for (int i = 0; i < FRAME_PIXELS; i++) {
+            int row = i / FRAME_COLS;
+            uint16_t raw;
+
+            switch (f) {
+                case 0:  raw = 2000; break;                                // Uniform mid-range
+                case 1:  raw = (uint16_t)(200 << row); break;              // Rows one stop apart
+                case 2:  raw = (i % 3 == 0) ? ADC_MAX_CODE : 1500; break;  // Saturated pixels
+                default: raw = (uint16_t)(i * 2); break;                   // Low light
+            }
+
+            light_frame_set_raw(&canned[f], i, raw);
+        }
+
+        light_frame_to_lux_matrix(&canned[f], canned_lux[f]);
+    }
+}
+
+/**
+ * Evict the cache by reading flash data through it
+ */
+static void evict_cache(void) {
+    uint32_t sum = 0;
+
+    for (int i = 0; i < CACHE_EVICT_WORDS; i += CACHE_LINE_WORDS) {
+        sum += ((volatile const uint32_t *)cache_evict_data)[i];
+    }
+    sink = (float)sum;
+}
+
+/* ---- Kernels ---- */
+
+static void run_convert_to_lux(int i) {
+    sink = convert_to_lux(i & ADC_MAX_CODE);
+}
+
+static void run_lut_lux(int i) {
+    sink = light_frame_lux_from_raw((uint16_t)(i & ADC_MAX_CODE));
+}
+
+static void run_ev_center(int i) {
+    sink = calculate_ev(canned_lux[i % CANNED_FRAMES], METERING_CENTER_WEIGHTED);
+}
+
+static void run_ev_highlight(int i) {
+    sink = calculate_ev(canned_lux[i % CANNED_FRAMES], METERING_HIGHLIGHT);
+}
+
+static void run_ev_from_frame(int i) {
+    sink = calculate_ev_from_frame(&canned[i % CANNED_FRAMES], METERING_CENTER_WEIGHTED);
+}
+
+static void run_frame_to_lux(int i) {
+    float lux[5][4];
+    light_frame_to_lux_matrix(&canned[i % CANNED_FRAMES], lux);
+    sink = lux[2][1];
+}
+
+static void run_frame_set_raw(int i) {
+    light_frame_set_raw(&scratch, i % FRAME_PIXELS, (uint16_t)(i & ADC_MAX_CODE));
+}
+
+static void run_shutter_speed(int i) {
+    sink = calculate_shutter_speed((i % 26) - 6.0f, 100);
+}
+
+static const bench_kernel_t kernels[] = {
+    { "convert_to_lux", (const void *)convert_to_lux, run_convert_to_lux },
+    { "lut_lux", (const void *)light_frame_lux_from_raw, run_lut_lux },
+    { "frame_set_raw", (const void *)light_frame_set_raw, run_frame_set_raw },
+    { "frame_to_lux_matrix", (const void *)light_frame_to_lux_matrix, run_frame_to_lux },
+    { "ev_center_weighted", (const void *)calculate_ev, run_ev_center },
+    { "ev_highlight", (const void *)calculate_ev, run_ev_highlight },
+    { "ev_from_frame", (const void *)calculate_ev_from_frame, run_ev_from_frame },
+    { "shutter_speed", (const void *)calculate_shutter_speed, run_shutter_speed },
+};
+
+/**
+ * Time every metering kernel
+ */
+bool bench_kernels(FILE *out, int iterations) {
+    if (iterations <= 0) {
+        return false;
+    }
+
+    uint32_t mhz = esp_rom_get_cpu_ticks_per_us();
+
+    build_canned_frames();
+    log_quiet_acquire();
+
+    fprintf(out, "Kernel benchmark: %d iterations, CPU %lu MHz\n", iterations, (unsigned long)mhz);
+    fprintf(out, "%-22s %-6s %10s %10s %9s\n", "kernel", "code", "cold cyc", "cycles/op", "us/op");
+
+    for (int k = 0; k < (int)(sizeof(kernels) / sizeof(kernels[0])); k++) {
+        const bench_kernel_t *kernel = &kernels[k];
+
+        evict_cache();
+        uint32_t start = esp_cpu_get_cycle_count();
+        kernel->run(0);
+        uint32_t cold = esp_cpu_get_cycle_count() - start;
+
+        uint64_t total = 0;
+        for (int done = 0; done < iterations; done += BENCH_CHUNK) {
+            int end = (iterations - done > BENCH_CHUNK) ? done + BENCH_CHUNK : iterations;
+
+            start = esp_cpu_get_cycle_count();
+            for (int i = done; i < end; i++) {
+                kernel->run(i);
+            }
+            total += esp_cpu_get_cycle_count() - start;
+        }
+
+        double per_op = (double)total / iterations;
+        fprintf(out, "%-22s %-6s %10lu %10.1f %9.3f\n", kernel->name,
+                esp_ptr_in_iram(kernel->code) ? "iram" : "flash",
+                (unsigned long)cold, per_op, per_op / mhz);
+    }
+
+    log_quiet_release();
+    return true;
+}
+
+/**
+ * Time frame acquisition under every scan strategy
+ * The active strategy is restored afterwards
+ */
+bool bench_scan(FILE *out, int iterations) {
+    if (iterations <= 0) {
+        return false;
+    }
+
+    scan_config_t saved;
+    int preset_count;
+    const scan_preset_t *presets = adc_reader_scan_presets(&preset_count);
+    light_frame_t frame;
+
+    adc_reader_get_scan_config(&saved);
+    log_quiet_acquire();
+
+    fprintf(out, "Scan benchmark: %d frames per strategy\n", iterations);
+    fprintf(out, "%-16s %12s %12s %10s\n", "strategy", "cold us", "us/frame", "frames/s");
+
+    for (int p = 0; p < preset_count; p++) {
+        adc_reader_set_scan_config(&presets[p].config);
+
+        // Scans yield during their settle delays, so they are timed by wall clock
+        evict_cache();
+        int64_t start_us = esp_timer_get_time();
+        measure_frame(&frame);
+        int64_t cold_us = esp_timer_get_time() - start_us;
+
+        start_us = esp_timer_get_time();
+        for (int i = 0; i < iterations; i++) {
+            measure_frame(&frame);
+        }
+        double per_frame_us = (double)(esp_timer_get_time() - start_us) / iterations;
+
+        fprintf(out, "%-16s %12lld %12.1f %10.2f\n", presets[p].name, (long long)cold_us,
+                per_frame_us, per_frame_us > 0 ? 1e6 / per_frame_us : 0.0);
+        ESP_LOGD(TAG, "Scan %s: %.1f us/frame", presets[p].name, per_frame_us);
+    }
+
+    adc_reader_set_scan_config(&saved);
+    log_quiet_release();
+    return true;
+}
@@ -0,0 +1,155 @@
+/*
+ * Frame Pool Module for 4x5 Camera Light Meter
+ * Implementation file
+ */
+
+#include "frame_pool.h"
+#include "esp_log.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+static const char *TAG = "FRAME_POOL";
+
+// A pooled frame; the frame must stay the first member so a frame
+// pointer can be mapped back to its slot
+typedef struct {
+    light_frame_t frame;
+    atomic_uint refcount;
+} pool_slot_t;
+
+static pool_slot_t slots[FRAME_POOL_SIZE];
+
+// Statistics
+static atomic_uint stat_acquired;
+static atomic_uint stat_exhausted;
+static atomic_uint stat_in_use;
+static atomic_uint stat_peak_in_use;
+
+/**
+ * Map a frame pointer back to its pool slot
+ * Returns NULL for frames that do not belong to the pool
+ */
+static pool_slot_t *slot_from_frame(const light_frame_t *frame) {
+    const pool_slot_t *slot = (const pool_slot_t *)frame;
+
+    if (slot < &slots[0] || slot >= &slots[FRAME_POOL_SIZE]) {
+        ESP_LOGE(TAG, "Frame %p does not belong to the pool", (const void *)frame);
+        return NULL;
+    }
+
+    return (pool_slot_t *)slot;
+}
+
+/**
+ * Initialize the frame pool
+ * All frames start free; must not be called while frames are referenced
+ */
+void frame_pool_init(void) {
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        atomic_init(&slots[i].refcount, 0);
+    }
+
+    atomic_store(&stat_acquired, 0);
+    atomic_store(&stat_exhausted, 0);
+    atomic_store(&stat_in_use, 0);
+    atomic_store(&stat_peak_in_use, 0);
+
+    ESP_LOGI(TAG, "Frame pool initialized (%d frames)", FRAME_POOL_SIZE);
+}
+
+/**
+ * Take a free frame for filling
+ * The caller owns the first reference; returns NULL when every frame is in use
+ */
+light_frame_t *frame_pool_acquire(void) {
+    for (int i = 0; i < FRAME_POOL_SIZE; i++) {
+        unsigned int expected = 0;
+
+        if (atomic_compare_exchange_strong(&slots[i].refcount, &expected, 1)) {
+            unsigned int in_use = atomic_fetch_add(&stat_in_use, 1) + 1;
+            unsigned int peak = atomic_load(&stat_peak_in_use);
+
+            while (in_use > peak &&
+                   !atomic_compare_exchange_weak(&stat_peak_in_use, &peak, in_use)) {
+            }
+
+            atomic_fetch_add(&stat_acquired, 1);
+            light_frame_clear(&slots[i].frame);
+            return &slots[i].frame;
+        }
+    }
+
+    atomic_fetch_add(&stat_exhausted, 1);
+    ESP_LOGW(TAG, "Frame pool exhausted - consumers are lagging");
+    return NULL;
+}
+
+/**
+ * Take an additional reference to a frame for another consumer
+ * Returns NULL for a free frame, so a stale pointer cannot revive its slot
+ */
+light_frame_t *frame_pool_ref(light_frame_t *frame) {
+    pool_slot_t *slot = slot_from_frame(frame);
+
+    if (slot == NULL) {
+        return NULL;
+    }
+
+    unsigned int current = atomic_load(&slot->refcount);
+
+    do {
+        if (current == 0) {
+            ESP_LOGE(TAG, "Frame %p referenced after it was released", (void *)frame);
+            return NULL;
+        }
+    } while (!atomic_compare_exchange_weak(&slot->refcount, &current, current + 1));
+
+    return frame;
+}
+
+/**
+ * Drop a reference; the frame returns to the pool when the last one is released
+ */
+void frame_pool_release(light_frame_t *frame) {
+    if (frame == NULL) {
+        return;
+    }
+
+    pool_slot_t *slot = slot_from_frame(frame);
+
+    if (slot == NULL) {
+        return;
+    }
+
+    unsigned int current = atomic_load(&slot->refcount);
+
+    do {
+        if (current == 0) {
+            ESP_LOGE(TAG, "Frame %p released more times than referenced", (void *)frame);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak(&slot->refcount, &current, current - 1));
+
+    if (current == 1) {
+        atomic_fetch_sub(&stat_in_use, 1);
+    }
+}
+
+/**
+ * Get the current reference count of a pooled frame
+ */
+uint32_t frame_pool_refcount(const light_frame_t *frame) {
+    pool_slot_t *slot = slot_from_frame(frame);
+
+    return (slot != NULL) ? atomic_load(&slot->refcount) : 0;
+}
+
+/**
+ * Get a snapshot of the pool counters
+ */
+void frame_pool_get_stats(frame_pool_stats_t *stats) {
+    stats->acquired = atomic_load(&stat_acquired);
+    stats->exhausted = atomic_load(&stat_exhausted);
+    stats->in_use = atomic_load(&stat_in_use);
+    stats->peak_in_use = atomic_load(&stat_peak_in_use);
+}
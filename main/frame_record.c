@@ -0,0 +1,517 @@
+/*
+ * Frame Record Module for 4x5 Camera Light Meter
+ * Implementation file
+ */
+
+#include "frame_record.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Whether measurements are currently being recorded to the console
+static bool recording = false;
+
+// Interval between streamed frames in ms, 0 when not streaming
+static uint32_t stream_interval_ms = 0;
+
+// Console format of REC records
+static frame_format_t output_format = FRAME_FORMAT_TEXT;
+static const char *format_names[] = { "text", "jsonl", "binary" };
+
+/**
+ * Enable or disable recording
+ */
+void frame_record_set_enabled(bool enabled) {
+    recording = enabled;
+}
+
+/**
+ * Check whether recording is enabled
+ */
+bool frame_record_enabled(void) {
+    return recording;
+}
+
+/**
+ * Stream a REC line every interval_ms without being asked, or stop with 0
+ */
+void frame_record_set_stream_interval(uint32_t interval_ms) {
+    stream_interval_ms = interval_ms;
+}
+
+/**
+ * Get the stream interval in ms (0 when not streaming)
+ */
+uint32_t frame_record_stream_interval(void) {
+    return stream_interval_ms;
+}
+
+/**
+ * Set the console format of REC records
+ */
+void frame_record_set_format(frame_format_t format) {
+    output_format = format;
+}
+
+/**
+ * Get the console format of REC records
+ */
+frame_format_t frame_record_get_format(void) {
+    return output_format;
+}
+
+/**
+ * Convert a record format to its name
+ */
+const char *frame_record_format_name(frame_format_t format) {
+    if ((unsigned)format < sizeof(format_names) / sizeof(format_names[0])) {
+        return format_names[format];
+    }
+    return "unknown";
+}
+
+/**
+ * Look up a record format by name
+ */
+bool frame_record_format_from_name(const char *name, frame_format_t *format) {
+    for (int i = 0; i < (int)(sizeof(format_names) / sizeof(format_names[0])); i++) {
+        if (strcmp(name, format_names[i]) == 0) {
+            *format = (frame_format_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Write a record as one console line in the current format
+ */
+void frame_record_write(FILE *out, const frame_record_t *record) {
+    char line[FRAME_RECORD_LINE_MAX];
+    int len;
+
+    switch (output_format) {
+        case FRAME_FORMAT_JSONL:
+            len = frame_record_format_json(record, line, sizeof(line));
+            break;
+        case FRAME_FORMAT_BINARY:
+            len = frame_record_encode_binary(record, (uint8_t *)line, sizeof(line));
+            break;
+        default:
+            len = frame_record_format(record, line, sizeof(line));
+            break;
+    }
+
+    if (len > 0) {
+        fwrite(line, 1, len, out);
+        fputc('\n', out);
+    }
+}
+
+/**
+ * Format a record as a single line (without newline)
+ * Floats use 9 significant digits so they parse back bit-exact
+ * Returns the formatted length, or -1 if the buffer is too small
+ */
+int frame_record_format(const frame_record_t *record, char *buffer, size_t buffer_size) {
+    int len = snprintf(buffer, buffer_size, "REC,%d,%lu,%lld,%d,%s,%.9g,%.9g",
+                       FRAME_RECORD_VERSION, (unsigned long)record->seq,
+                       (long long)record->time_us, record->iso,
+                       get_metering_mode_name(record->mode),
+                       record->k_value, record->ev);
+
+    for (int i = 0; i < FRAME_PIXELS && len >= 0 && (size_t)len < buffer_size; i++) {
+        len += snprintf(buffer + len, buffer_size - len, ",%u", record->raw[i]);
+    }
+
+    return (len >= 0 && (size_t)len < buffer_size) ? len : -1;
+}
+
+/**
+ * Parse a REC line
+ * Returns false for other lines or malformed records
+ */
+bool frame_record_parse(const char *line, frame_record_t *record) {
+    if (strncmp(line, "REC,", 4) != 0) {
+        return false;
+    }
+
+    char *end;
+    const char *p = line + 4;
+
+    if (strtol(p, &end, 10) != FRAME_RECORD_VERSION || *end != ',') {
+        return false;
+    }
+
+    record->seq = (uint32_t)strtoul(end + 1, &end, 10);
+    if (*end != ',') return false;
+    record->time_us = strtoll(end + 1, &end, 10);
+    if (*end != ',') return false;
+    record->iso = (int)strtol(end + 1, &end, 10);
+    if (*end != ',') return false;
+
+    // Metering mode by name
+    p = end + 1;
+    const char *comma = strchr(p, ',');
+    char mode_name[24];
+    if (comma == NULL || (size_t)(comma - p) >= sizeof(mode_name)) {
+        return false;
+    }
+    memcpy(mode_name, p, comma - p);
+    mode_name[comma - p] = '\0';
+    record->mode = get_metering_mode_from_name(mode_name);
+    if (strcmp(get_metering_mode_name(record->mode), mode_name) != 0) {
+        return false;
+    }
+
+    record->k_value = strtof(comma + 1, &end);
+    if (*end != ',') return false;
+    record->ev = strtof(end + 1, &end);
+
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        if (*end != ',') return false;
+        unsigned long raw = strtoul(end + 1, &end, 10);
+        if (raw > ADC_MAX_CODE) return false;
+        record->raw[i] = (uint16_t)raw;
+    }
+
+    return *end == '\0' || *end == '\r' || *end == '\n';
+}
+
+/**
+ * Format a record as a single JSON object (without newline)
+ * Returns the formatted length, or -1 if the buffer is too small
+ */
+int frame_record_format_json(const frame_record_t *record, char *buffer, size_t buffer_size) {
+    int len = snprintf(buffer, buffer_size,
+                       "{\"rec\":%d,\"seq\":%lu,\"t_us\":%lld,\"iso\":%d,\"mode\":\"%s\",\"k\":%.9g,\"ev\":%.9g,\"raw\":[",
+                       FRAME_RECORD_VERSION, (unsigned long)record->seq,
+                       (long long)record->time_us, record->iso,
+                       get_metering_mode_name(record->mode),
+                       record->k_value, record->ev);
+
+    for (int i = 0; i < FRAME_PIXELS && len >= 0 && (size_t)len < buffer_size; i++) {
+        len += snprintf(buffer + len, buffer_size - len, i ? ",%u" : "%u", record->raw[i]);
+    }
+    if (len >= 0 && (size_t)len < buffer_size) {
+        len += snprintf(buffer + len, buffer_size - len, "]}");
+    }
+
+    return (len >= 0 && (size_t)len < buffer_size) ? len : -1;
+}
+
+/**
+ * Match "name": at *p and step past it
+ */
+static bool match_json_key(const char **p, const char *name) {
+    size_t n = strlen(name);
+    const char *s = *p;
+
+    if (s[0] != '"' || strncmp(s + 1, name, n) != 0 || s[n + 1] != '"' || s[n + 2] != ':') {
+        return false;
+    }
+    *p = s + n + 3;
+    return true;
+}
+
+/**
+ * Parse a JSON record as written by frame_record_format_json
+ * Keys may come in any order, but every key must be present and no other
+ * key is accepted. The line may end at a NUL, CR or LF, so it can be parsed
+ * in place in a larger buffer
+ */
+bool frame_record_parse_json(const char *line, frame_record_t *record) {
+    enum { KEY_REC = 1, KEY_SEQ = 2, KEY_TIME = 4, KEY_ISO = 8, KEY_MODE = 16, KEY_K = 32, KEY_EV = 64, KEY_RAW = 128 };
+    unsigned seen = 0;
+    const char *p = line;
+    char *end;
+
+    if (*p++ != '{') {
+        return false;
+    }
+
+    while (*p == '"') {
+        if (match_json_key(&p, "rec")) {
+            if (strtol(p, &end, 10) != FRAME_RECORD_VERSION) return false;
+            seen |= KEY_REC;
+        } else if (match_json_key(&p, "seq")) {
+            record->seq = (uint32_t)strtoul(p, &end, 10);
+            seen |= KEY_SEQ;
+        } else if (match_json_key(&p, "t_us")) {
+            record->time_us = strtoll(p, &end, 10);
+            seen |= KEY_TIME;
+        } else if (match_json_key(&p, "iso")) {
+            record->iso = (int)strtol(p, &end, 10);
+            seen |= KEY_ISO;
+        } else if (match_json_key(&p, "mode")) {
+            char mode_name[24];
+            size_t n = 0;
+
+            if (*p++ != '"') return false;
+            while (p[n] != '"' && p[n] != '\0' && p[n] != '\n' && n < sizeof(mode_name) - 1) {
+                mode_name[n] = p[n];
+                n++;
+            }
+            if (p[n] != '"') return false;
+            mode_name[n] = '\0';
+            record->mode = get_metering_mode_from_name(mode_name);
+            if (strcmp(get_metering_mode_name(record->mode), mode_name) != 0) return false;
+            end = (char *)p + n + 1;
+            seen |= KEY_MODE;
+        } else if (match_json_key(&p, "k")) {
+            record->k_value = strtof(p, &end);
+            seen |= KEY_K;
+        } else if (match_json_key(&p, "ev")) {
+            record->ev = strtof(p, &end);
+            seen |= KEY_EV;
+        } else if (match_json_key(&p, "raw")) {
+            if (*p != '[') return false;
+            end = (char *)p;
+            for (int i = 0; i < FRAME_PIXELS; i++) {
+                if (*end != (i ? ',' : '[')) return false;
+                unsigned long raw = strtoul(end + 1, &end, 10);
+                if (raw > ADC_MAX_CODE) return false;
+                record->raw[i] = (uint16_t)raw;
+            }
+            if (*end++ != ']') return false;
+            seen |= KEY_RAW;
+        } else {
+            return false;
+        }
+
+        if (end == p) return false;
+        p = end;
+        if (*p != ',') break;
+        p++;
+    }
+
+    return *p == '}' && seen == 0xFF;
+}
+
+// CRC-16/CCITT-FALSE of each 4-bit value, for two table steps per byte
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/**
+ * CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+ */
+uint16_t frame_record_crc16(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+
+    for (size_t i = 0; i < length; i++) {
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ crc16_nibble[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+static uint8_t *put_le(uint8_t *p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        *p++ = (uint8_t)(value >> (8 * i));
+    }
+    return p;
+}
+
+static uint64_t get_le(const uint8_t **p, int bytes) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)(*p)[i] << (8 * i);
+    }
+    *p += bytes;
+    return value;
+}
+
+/**
+ * Encode a record as a binary line (without newline)
+ * Returns the encoded length (FRAME_BINARY_LINE_SIZE), or -1 if the buffer is too small
+ */
+int frame_record_encode_binary(const frame_record_t *record, uint8_t *buffer, size_t buffer_size) {
+    uint8_t packed[FRAME_BINARY_SIZE];
+    uint8_t *p = packed;
+    uint32_t k_bits, ev_bits;
+
+    if (buffer_size < FRAME_BINARY_LINE_SIZE) {
+        return -1;
+    }
+
+    memcpy(&k_bits, &record->k_value, sizeof(k_bits));
+    memcpy(&ev_bits, &record->ev, sizeof(ev_bits));
+
+    p = put_le(p, FRAME_RECORD_VERSION, 1);
+    p = put_le(p, record->seq, 4);
+    p = put_le(p, (uint64_t)record->time_us, 8);
+    p = put_le(p, (uint32_t)record->iso, 4);
+    p = put_le(p, (uint8_t)record->mode, 1);
+    p = put_le(p, k_bits, 4);
+    p = put_le(p, ev_bits, 4);
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        p = put_le(p, record->raw[i], 2);
+    }
+    put_le(p, frame_record_crc16(packed, FRAME_BINARY_SIZE - 2), 2);
+
+    // COBS removes zero bytes (one code byte per run, as the record is under 254 bytes);
+    // the XOR then turns "no zero" into "no newline"
+    uint8_t *out = buffer + 1;
+    size_t code_pos = 0, out_pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < FRAME_BINARY_SIZE; i++) {
+        if (packed[i] == 0) {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+        } else {
+            out[out_pos++] = packed[i];
+            code++;
+        }
+    }
+    out[code_pos] = code;
+
+    buffer[0] = FRAME_BINARY_SYNC;
+    for (size_t i = 0; i < out_pos; i++) {
+        out[i] ^= '\n';
+    }
+    return (int)(out_pos + 1);
+}
+
+/**
+ * Decode a binary line (without its newline; a trailing CR from console
+ * line-ending translation is accepted)
+ * Returns true for a valid record; crc_ok, if given, is false when the line
+ * decoded but failed its CRC
+ */
+bool frame_record_decode_binary(const uint8_t *line, size_t length, frame_record_t *record, bool *crc_ok) {
+    uint8_t encoded[FRAME_BINARY_LINE_SIZE - 1];
+    uint8_t packed[FRAME_BINARY_SIZE];
+    size_t in = 0, out = 0;
+
+    if (crc_ok) {
+        *crc_ok = true;
+    }
+    if (length == FRAME_BINARY_LINE_SIZE + 1 && line[length - 1] == '\r') {
+        length--;
+    }
+    if (length != FRAME_BINARY_LINE_SIZE || line[0] != FRAME_BINARY_SYNC) {
+        return false;
+    }
+
+    for (size_t i = 0; i < sizeof(encoded); i++) {
+        encoded[i] = line[i + 1] ^ '\n';
+    }
+
+    while (in < sizeof(encoded)) {
+        uint8_t code = encoded[in++];
+        if (code == 0 || in + code - 1 > sizeof(encoded) || out + code - 1 > sizeof(packed)) {
+            return false;
+        }
+        for (int i = 1; i < code; i++) {
+            packed[out++] = encoded[in++];
+        }
+        if (in < sizeof(encoded)) {
+            if (out >= sizeof(packed)) return false;
+            packed[out++] = 0;
+        }
+    }
+    if (out != sizeof(packed)) {
+        return false;
+    }
+
+    const uint8_t *p = packed;
+    if (get_le(&p, 1) != FRAME_RECORD_VERSION) {
+        return false;
+    }
+    if (frame_record_crc16(packed, FRAME_BINARY_SIZE - 2) != (packed[FRAME_BINARY_SIZE - 2] | packed[FRAME_BINARY_SIZE - 1] << 8)) {
+        if (crc_ok) {
+            *crc_ok = false;
+        }
+        return false;
+    }
+
+    uint32_t k_bits, ev_bits;
+    record->seq = (uint32_t)get_le(&p, 4);
+    record->time_us = (int64_t)get_le(&p, 8);
+    record->iso = (int)(uint32_t)get_le(&p, 4);
+    record->mode = (metering_mode_t)get_le(&p, 1);
+    k_bits = (uint32_t)get_le(&p, 4);
+    ev_bits = (uint32_t)get_le(&p, 4);
+    memcpy(&record->k_value, &k_bits, sizeof(k_bits));
+    memcpy(&record->ev, &ev_bits, sizeof(ev_bits));
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        record->raw[i] = (uint16_t)get_le(&p, 2);
+        if (record->raw[i] > ADC_MAX_CODE) return false;
+    }
+
+    return record->mode >= METERING_CENTER_WEIGHTED && record->mode <= METERING_HIGHLIGHT;
+}
+
+/**
+ * Print the ADC calibration as a CAL line
+ * Consecutive codes differ by a few mV, so each delta is a single digit;
+ * other deltas are written as (n)
+ */
+void frame_record_print_calibration(FILE *out, int (*raw_to_mv)(int adc_value), int codes) {
+    int previous = raw_to_mv(0);
+
+    fprintf(out, "CAL,%d,%d,%d,", FRAME_RECORD_VERSION, codes, previous);
+
+    for (int code = 1; code < codes; code++) {
+        int mv = raw_to_mv(code);
+        int delta = mv - previous;
+
+        if (delta >= 0 && delta <= 9) {
+            fputc('0' + delta, out);
+        } else {
+            fprintf(out, "(%d)", delta);
+        }
+        previous = mv;
+    }
+
+    fputc('\n', out);
+}
+
+/**
+ * Parse a CAL line into a per-code mV table
+ * Returns the number of codes, or -1 for other lines or malformed records
+ */
+int frame_record_parse_calibration(const char *line, int *mv_table, int max_codes) {
+    if (strncmp(line, "CAL,", 4) != 0) {
+        return -1;
+    }
+
+    char *end;
+    if (strtol(line + 4, &end, 10) != FRAME_RECORD_VERSION || *end != ',') {
+        return -1;
+    }
+
+    long codes = strtol(end + 1, &end, 10);
+    if (*end != ',' || codes < 1 || codes > max_codes) {
+        return -1;
+    }
+
+    int mv = (int)strtol(end + 1, &end, 10);
+    if (*end != ',') {
+        return -1;
+    }
+
+    const char *p = end + 1;
+    mv_table[0] = mv;
+
+    for (int code = 1; code < codes; code++) {
+        if (*p >= '0' && *p <= '9') {
+            mv += *p++ - '0';
+        } else if (*p == '(') {
+            mv += (int)strtol(p + 1, &end, 10);
+            if (*end != ')') {
+                return -1;
+            }
+            p = end + 1;
+        } else {
+            return -1;
+        }
+        mv_table[code] = mv;
+    }
+
+    return (int)codes;
+}
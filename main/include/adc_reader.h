@@ -6,7 +6,11 @@
  #ifndef ADC_READER_H
  #define ADC_READER_H
  
+ #include <stdbool.h>
+ #include <stdint.h>
+ #include <stdio.h>
  #include "esp_adc/adc_oneshot.h"
+ #include "light_frame.h"  // For light_frame_t and led_measurement_t
  
  // ADC pin definitions using GPIO pins
  // Note: ESP32-C3 only supports ADC1 with channels 0-4
@@ -16,20 +20,55 @@
  #define ADC_LED1316_GPIO     3   // For LEDs 13-16, using GPIO 3
  #define ADC_LED1720_GPIO     4   // For LEDs 17-20, using GPIO 4
  
- // Structure to store detailed measurement results
+ // Order in which the scan visits the pixels
+ typedef enum {
+     SCAN_ORDER_SERIAL,              // One pixel at a time, row by row
+     SCAN_ORDER_COLUMN_PARALLEL      // Select a column once, then convert all five row channels
+ } scan_order_t;
+ 
+ // Acquisition timing and strategy of a frame scan
+ typedef struct {
+     scan_order_t order;
+     bool hold_enable;               // Keep the multiplexers enabled for the whole scan
+     uint32_t mux_settle_us;         // Wait after switching the multiplexer column
+     uint32_t enable_settle_us;      // Wait after enabling the measurement circuit
+     uint32_t pixel_gap_us;          // Wait after each pixel (serial) or column (column-parallel)
+     uint8_t oversample;             // Conversions averaged per pixel
+     uint32_t oversample_interval_us;    // Wait between averaged conversions
+ } scan_config_t;
+ 
+ // A named scan strategy
  typedef struct {
-     int adc_value;
-     float voltage;
-     float lux;
- } led_measurement_t;
+     const char *name;
+     scan_config_t config;
+ } scan_preset_t;
+ 
+ // Original scan timing: 1 ms mux settle, 10 ms enable settle, 50 ms between pixels
+ #define SCAN_CONFIG_DEFAULT { \
+     .order = SCAN_ORDER_SERIAL, .hold_enable = false, \
+     .mux_settle_us = 1000, .enable_settle_us = 10000, .pixel_gap_us = 50000, \
+     .oversample = 1, .oversample_interval_us = 0 }
  
  // Function prototypes
  void adc_reader_init(void);
  int read_adc_for_led(int row, int col);
+ float get_voltage_from_adc(int adc_value);
  float convert_to_lux(int adc_value);
  void measure_all_leds(float lux_matrix[5][4]);
  
  // New function for detailed measurements
  void measure_all_leds_detailed(led_measurement_t measurements[5][4]);
  
+ // Raw scan into a compact frame (voltage and lux derived on demand)
+ void measure_frame(light_frame_t *frame);
+ 
+ // Scan strategy used by measure_frame()
+ void adc_reader_set_scan_config(const scan_config_t *config);
+ void adc_reader_get_scan_config(scan_config_t *config);
+ const scan_preset_t *adc_reader_scan_presets(int *count);
+ const scan_preset_t *adc_reader_find_scan_preset(const char *name);
+ 
+ // Calibration curve for frame recordings
+ void adc_reader_print_calibration(FILE *out);
+ 
  #endif // ADC_READER_H
\ No newline at end of file
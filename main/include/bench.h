@@ -0,0 +1,16 @@
+/*
+ * Bench Module for 4x5 Camera Light Meter
+ * On-device timing of the metering kernels and of acquisition under each scan strategy
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Function prototypes
+bool bench_kernels(FILE *out, int iterations);
+bool bench_scan(FILE *out, int iterations);
+
+#endif // BENCH_H
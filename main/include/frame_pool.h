@@ -0,0 +1,31 @@
+/*
+ * Frame Pool Module for 4x5 Camera Light Meter
+ * Fixed set of reference-counted frames shared between consumers
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stdint.h>
+#include "light_frame.h"
+
+// Number of frames in flight at once (producer + consumers)
+#define FRAME_POOL_SIZE     4
+
+// Pool usage counters
+typedef struct {
+    uint32_t acquired;      // Frames handed out to the producer
+    uint32_t exhausted;     // Acquisitions that found no free frame
+    uint32_t in_use;        // Frames currently referenced
+    uint32_t peak_in_use;   // Highest in_use seen since init
+} frame_pool_stats_t;
+
+// Function prototypes
+void frame_pool_init(void);
+light_frame_t *frame_pool_acquire(void);
+light_frame_t *frame_pool_ref(light_frame_t *frame);
+void frame_pool_release(light_frame_t *frame);
+uint32_t frame_pool_refcount(const light_frame_t *frame);
+void frame_pool_get_stats(frame_pool_stats_t *stats);
+
+#endif // FRAME_POOL_H
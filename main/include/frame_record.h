@@ -0,0 +1,79 @@
+/*
+ * Frame Record Module for 4x5 Camera Light Meter
+ * Record formats for raw frames plus the configuration and result of metering them
+ *
+ * Records are single console lines, so a plain capture of the console is a valid recording:
+ *   CAL,<version>,<codes>,<mV of code 0>,<per-code mV deltas as digits>
+ *   REC,<version>,<seq>,<time us>,<iso>,<mode>,<k>,<ev>,<raw 1>,...,<raw 20>
+ * or, with 'config output jsonl':
+ *   {"rec":<version>,"seq":..,"t_us":..,"iso":..,"mode":"..","k":..,"ev":..,"raw":[..]}
+ * or, with 'config output binary', FRAME_BINARY_SYNC followed by the packed record
+ * and its CRC-16, COBS-encoded and XORed with '\n' so the line holds no newline:
+ *   version u8, seq u32, time us i64, iso u32, mode u8, k f32, ev f32, raw u16 x 20, crc u16
+ * (little-endian; the CRC is CRC-16/CCITT-FALSE over everything before it).
+ * CAL lines are always text.
+ */
+
+#ifndef FRAME_RECORD_H
+#define FRAME_RECORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "light_frame.h"
+#include "light_meter.h"
+
+#define FRAME_RECORD_VERSION    1
+#define FRAME_RECORD_LINE_MAX   256
+
+// Binary records
+#define FRAME_BINARY_SYNC       0xA5
+#define FRAME_BINARY_SIZE       68                          // Packed record with CRC
+#define FRAME_BINARY_LINE_SIZE  (1 + FRAME_BINARY_SIZE + 1) // Sync, COBS overhead, record
+
+// Default interval between streamed frames (about 30 per second)
+#define FRAME_STREAM_INTERVAL_MS    33
+
+// Console format of REC records
+typedef enum {
+    FRAME_FORMAT_TEXT,
+    FRAME_FORMAT_JSONL,
+    FRAME_FORMAT_BINARY
+} frame_format_t;
+
+// One recorded measurement
+typedef struct {
+    uint32_t seq;
+    int64_t time_us;
+    int iso;
+    metering_mode_t mode;
+    float k_value;
+    float ev;
+    uint16_t raw[FRAME_PIXELS];
+} frame_record_t;
+
+// Function prototypes
+void frame_record_set_enabled(bool enabled);
+bool frame_record_enabled(void);
+void frame_record_set_stream_interval(uint32_t interval_ms);
+uint32_t frame_record_stream_interval(void);
+
+void frame_record_set_format(frame_format_t format);
+frame_format_t frame_record_get_format(void);
+const char *frame_record_format_name(frame_format_t format);
+bool frame_record_format_from_name(const char *name, frame_format_t *format);
+void frame_record_write(FILE *out, const frame_record_t *record);
+
+int frame_record_format(const frame_record_t *record, char *buffer, size_t buffer_size);
+bool frame_record_parse(const char *line, frame_record_t *record);
+int frame_record_format_json(const frame_record_t *record, char *buffer, size_t buffer_size);
+bool frame_record_parse_json(const char *line, frame_record_t *record);
+int frame_record_encode_binary(const frame_record_t *record, uint8_t *buffer, size_t buffer_size);
+bool frame_record_decode_binary(const uint8_t *line, size_t length, frame_record_t *record, bool *crc_ok);
+uint16_t frame_record_crc16(const uint8_t *data, size_t length);
+
+void frame_record_print_calibration(FILE *out, int (*raw_to_mv)(int adc_value), int codes);
+int frame_record_parse_calibration(const char *line, int *mv_table, int max_codes);
+
+#endif // FRAME_RECORD_H
@@ -0,0 +1,65 @@
+/*
+ * Light Frame Module for 4x5 Camera Light Meter
+ * Compact storage of one sensor scan, with voltage and lux derived on demand
+ */
+
+#ifndef LIGHT_FRAME_H
+#define LIGHT_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Sensor matrix geometry (5 rows, 4 columns)
+#define FRAME_ROWS          5
+#define FRAME_COLS          4
+#define FRAME_PIXELS        (FRAME_ROWS * FRAME_COLS)
+
+// Row-major index of a 0-indexed (row, col) pixel
+#define FRAME_INDEX(row, col)   ((row) * FRAME_COLS + (col))
+
+// ADC code range and validity thresholds
+#define ADC_MAX_CODE            4095
+#define ADC_CODE_COUNT          (ADC_MAX_CODE + 1)
+#define ADC_SATURATION_CODE     4090    // Readings at or above this are saturated
+#define MIN_RELIABLE_LUX        10.0f   // Minimum reliable reading per specs
+
+// Constants for lux conversion: Viout = 0.0057 × 10^-6 × Ev × R1
+#define RLOAD_OHM               1300     // 739 + 11 Ohm RDSon (using 750 ohm standard value)
+#define PHOTODIODE_SENSITIVITY  0.0057e-6f  // 0.0057 × 10^-6
+
+// Expanded per-pixel view of a measurement (ADC, voltage and lux)
+typedef struct {
+    int adc_value;
+    float voltage;
+    float lux;
+} led_measurement_t;
+
+// Canonical frame: raw codes plus one bit per pixel in each flag mask
+typedef struct {
+    uint16_t raw[FRAME_PIXELS];   // Raw ADC codes, row-major
+    uint32_t saturated_mask;      // Bit set when the pixel is saturated
+    uint32_t low_mask;            // Bit set when the pixel is below MIN_RELIABLE_LUX
+} light_frame_t;
+
+/**
+ * Convert a voltage to lux using the photodiode formula
+ */
+static inline float lux_from_voltage(float voltage) {
+    return voltage / (PHOTODIODE_SENSITIVITY * RLOAD_OHM);
+}
+
+// Function prototypes
+void light_frame_init_lut(float (*raw_to_voltage)(int adc_value));
+float light_frame_voltage_from_raw(uint16_t raw);
+float light_frame_lux_from_raw(uint16_t raw);
+
+void light_frame_clear(light_frame_t *frame);
+void light_frame_set_raw(light_frame_t *frame, int index, uint16_t raw);
+float light_frame_voltage(const light_frame_t *frame, int index);
+float light_frame_lux(const light_frame_t *frame, int index);
+
+// Views for consumers that need the expanded values
+void light_frame_to_lux_matrix(const light_frame_t *frame, float lux_matrix[5][4]);
+void light_frame_to_measurements(const light_frame_t *frame, led_measurement_t measurements[5][4]);
+
+#endif // LIGHT_FRAME_H
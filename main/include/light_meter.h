@@ -8,7 +8,7 @@
 
 #include <stddef.h>  // For size_t
 #include <stdbool.h>  // For bool
-#include "adc_reader.h"  // For led_measurement_t
+#include "light_frame.h"  // For light_frame_t and led_measurement_t
 
 // Metering modes
 typedef enum {
@@ -21,6 +21,7 @@ typedef enum {
 // Function prototypes
 float calculate_ev(float lux_matrix[5][4], metering_mode_t mode);
 float calculate_ev_from_detailed(led_measurement_t measurements[5][4], metering_mode_t mode);
+float calculate_ev_from_frame(const light_frame_t *frame, metering_mode_t mode);
 float calculate_shutter_speed(float ev, int iso);
 void get_exposure_recommendation(float ev, int iso, char *buffer, size_t buffer_size);
 bool set_metering_mode(metering_mode_t mode);
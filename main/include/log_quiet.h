@@ -0,0 +1,13 @@
+/*
+ * Log Quiet Module for 4x5 Camera Light Meter
+ * Shared quieting of the per-measurement logs, restoring the levels they had before
+ */
+
+#ifndef LOG_QUIET_H
+#define LOG_QUIET_H
+
+// Function prototypes
+void log_quiet_acquire(void);
+void log_quiet_release(void);
+
+#endif // LOG_QUIET_H
@@ -4,10 +4,13 @@
  */
 
  #include "led_control.h"
+ #include "esp_attr.h"
  #include "esp_log.h"
  #include "driver/gpio.h"
  
  static const char *TAG = "LED_CONTROL";
+ // Tag for the IRAM functions, whose logging must not touch flash
+ static DRAM_ATTR const char DRAM_TAG[] = "LED_CONTROL";
  
  /**
   * Initialize the LED control module
@@ -35,11 +38,13 @@
  /**
   * Select an LED based on row (1-5) and column (1-4)
   * This sets the appropriate multiplexer signals
+  * In IRAM with gpio_set_level (CONFIG_GPIO_CTRL_FUNC_IN_IRAM) for the scan loop;
+  * it logs through ESP_DRAM_LOGx so no format string is read from flash either
   */
- void select_led(int row, int col) {
+ void IRAM_ATTR select_led(int row, int col) {
      // Validate inputs
      if (row < 1 || row > 5 || col < 1 || col > 4) {
-         ESP_LOGE(TAG, "Invalid LED coordinates: row %d, col %d", row, col);
+         ESP_DRAM_LOGE(DRAM_TAG, "Invalid LED coordinates: row %d, col %d", row, col);
          return;
      }
      
@@ -52,15 +57,15 @@
      gpio_set_level(MULTIPLEX_0_PIN, mux_setting & 0x01);
      gpio_set_level(MULTIPLEX_1_PIN, (mux_setting >> 1) & 0x01);
      
-     ESP_LOGD(TAG, "Selected LED at row %d, column %d", row, col);
+     ESP_DRAM_LOGD(DRAM_TAG, "Selected LED at row %d, column %d", row, col);
  }
  
  /**
   * Enable or disable the measurement circuit
   * The nENABLE pin is active LOW
   */
- void enable_measurement(bool enable) {
+ void IRAM_ATTR enable_measurement(bool enable) {
      gpio_set_level(ENABLE_PIN, enable ? 0 : 1);
      
-     ESP_LOGD(TAG, "Measurement circuit %s", enable ? "enabled" : "disabled");
+     ESP_DRAM_LOGD(DRAM_TAG, "Measurement circuit %s", enable ? DRAM_STR("enabled") : DRAM_STR("disabled"));
  }
\ No newline at end of file
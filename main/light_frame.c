@@ -0,0 +1,129 @@
+/*
+ * Light Frame Module for 4x5 Camera Light Meter
+ * Implementation file
+ */
+
+#include "light_frame.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include <string.h>
+
+static const char *TAG = "LIGHT_FRAME";
+
+// Voltage for every ADC code, filled once the ADC calibration is known
+// Mutable statics already live in internal DRAM (.bss), so lookups never go
+// through the flash cache; DRAM_ATTR would only add 16 KB to the image
+static float voltage_lut[ADC_CODE_COUNT];
+static bool lut_ready = false;
+
+// Smallest ADC code whose lux reaches MIN_RELIABLE_LUX
+static uint16_t min_reliable_code = 0;
+
+/**
+ * Build the voltage lookup table from a raw-to-voltage conversion
+ * Called by the ADC reader once calibration is set up
+ */
+void light_frame_init_lut(float (*raw_to_voltage)(int adc_value)) {
+    min_reliable_code = ADC_CODE_COUNT;
+
+    for (int code = 0; code < ADC_CODE_COUNT; code++) {
+        voltage_lut[code] = raw_to_voltage(code);
+
+        if (min_reliable_code == ADC_CODE_COUNT &&
+            lux_from_voltage(voltage_lut[code]) >= MIN_RELIABLE_LUX) {
+            min_reliable_code = code;
+        }
+    }
+
+    lut_ready = true;
+    ESP_LOGI(TAG, "Voltage LUT built (%d codes, min reliable code %d)",
+             ADC_CODE_COUNT, min_reliable_code);
+}
+
+/**
+ * Get the voltage for a raw ADC code
+ * Falls back to the uncalibrated 3.3V linear conversion before the LUT is built
+ */
+float IRAM_ATTR light_frame_voltage_from_raw(uint16_t raw) {
+    if (raw > ADC_MAX_CODE) {
+        raw = ADC_MAX_CODE;
+    }
+
+    if (lut_ready) {
+        return voltage_lut[raw];
+    }
+
+    return (raw >= ADC_SATURATION_CODE) ? 3.3f : (raw * 3.3f) / 4095.0f;
+}
+
+/**
+ * Get the lux for a raw ADC code
+ */
+float IRAM_ATTR light_frame_lux_from_raw(uint16_t raw) {
+    return lux_from_voltage(light_frame_voltage_from_raw(raw));
+}
+
+/**
+ * Reset a frame to all-zero readings
+ */
+void light_frame_clear(light_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+    frame->low_mask = (1u << FRAME_PIXELS) - 1;
+}
+
+/**
+ * Store a raw reading and update the pixel's flag bits
+ * In IRAM as part of the acquisition loop
+ */
+void IRAM_ATTR light_frame_set_raw(light_frame_t *frame, int index, uint16_t raw) {
+    uint32_t bit = 1u << index;
+
+    frame->raw[index] = raw;
+    frame->saturated_mask &= ~bit;
+    frame->low_mask &= ~bit;
+
+    if (raw >= ADC_SATURATION_CODE) {
+        frame->saturated_mask |= bit;
+    }
+
+    bool low = lut_ready ? (raw < min_reliable_code)
+                         : (light_frame_lux_from_raw(raw) < MIN_RELIABLE_LUX);
+    if (low) {
+        frame->low_mask |= bit;
+    }
+}
+
+/**
+ * Get the voltage of one pixel
+ */
+float light_frame_voltage(const light_frame_t *frame, int index) {
+    return light_frame_voltage_from_raw(frame->raw[index]);
+}
+
+/**
+ * Get the lux of one pixel
+ */
+float light_frame_lux(const light_frame_t *frame, int index) {
+    return light_frame_lux_from_raw(frame->raw[index]);
+}
+
+/**
+ * Expand a frame into a lux matrix
+ */
+void light_frame_to_lux_matrix(const light_frame_t *frame, float lux_matrix[5][4]) {
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        lux_matrix[i / FRAME_COLS][i % FRAME_COLS] = light_frame_lux(frame, i);
+    }
+}
+
+/**
+ * Expand a frame into detailed per-LED measurements
+ */
+void light_frame_to_measurements(const light_frame_t *frame, led_measurement_t measurements[5][4]) {
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        led_measurement_t *m = &measurements[i / FRAME_COLS][i % FRAME_COLS];
+        m->adc_value = frame->raw[i];
+        m->voltage = light_frame_voltage(frame, i);
+        m->lux = lux_from_voltage(m->voltage);
+    }
+}
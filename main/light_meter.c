@@ -215,6 +215,36 @@ float calculate_ev_from_detailed(led_measurement_t measurements[5][4], metering_
     return ev;
 }
 
+/**
+ * Calculate Exposure Value (EV) from a compact frame
+ * Lux is derived from the raw codes; flagged pixels are skipped as in the detailed path
+ */
+float calculate_ev_from_frame(const light_frame_t *frame, metering_mode_t mode) {
+    float lux_matrix[5][4];
+    float *lux = &lux_matrix[0][0];
+    uint32_t skip_mask = frame->saturated_mask | frame->low_mask;
+    
+    for (int i = 0; i < FRAME_PIXELS; i++) {
+        if (skip_mask & (1u << i)) {
+            ESP_LOGW(TAG, "Skipping %s reading at row %d, col %d (ADC: %d)", 
+                     (frame->saturated_mask & (1u << i)) ? "saturated" : "too low",
+                     i / FRAME_COLS + 1, i % FRAME_COLS + 1, frame->raw[i]);
+            lux[i] = 0.0f;
+            continue;
+        }
+        
+        lux[i] = light_frame_lux(frame, i);
+    }
+    
+    // Calculate EV using the appropriate metering mode
+    float ev = calculate_ev(lux_matrix, mode);
+    
+    // Clamp EV to reasonable range for photography (-6 to 20)
+    ev = fmaxf(-6.0f, fminf(20.0f, ev));
+    
+    return ev;
+}
+
 /**
  * Calculate recommended shutter speed based on EV
  * Returns the shutter speed in seconds using the K Method
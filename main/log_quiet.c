@@ -0,0 +1,49 @@
+/*
+ * Log Quiet Module for 4x5 Camera Light Meter
+ * Implementation file
+ *
+ * Benchmarks and frame streaming both keep the per-measurement logs down to
+ * errors while they run. Each holds the quiet state through acquire/release;
+ * the first holder saves the tags' levels and the last one restores them, so
+ * neither forces a level the user set with another log configuration. Called
+ * from the main task only (console commands and the main loop).
+ */
+
+#include "log_quiet.h"
+#include "esp_log.h"
+
+// Tags whose per-measurement logging would flood a stream or dominate benchmark timings
+static const char *quiet_tags[] = { "LIGHT_METER", "ADC_READER" };
+#define QUIET_TAG_COUNT     (int)(sizeof(quiet_tags) / sizeof(quiet_tags[0]))
+
+static esp_log_level_t saved_levels[QUIET_TAG_COUNT];
+static int holders = 0;
+
+/**
+ * Quiet the per-measurement logs until the matching log_quiet_release()
+ */
+void log_quiet_acquire(void) {
+    if (holders++ > 0) {
+        return;
+    }
+
+    for (int i = 0; i < QUIET_TAG_COUNT; i++) {
+        saved_levels[i] = esp_log_level_get(quiet_tags[i]);
+        if (saved_levels[i] > ESP_LOG_ERROR) {
+            esp_log_level_set(quiet_tags[i], ESP_LOG_ERROR);
+        }
+    }
+}
+
+/**
+ * Drop a hold on the quiet state; the last one restores the saved levels
+ */
+void log_quiet_release(void) {
+    if (holders == 0 || --holders > 0) {
+        return;
+    }
+
+    for (int i = 0; i < QUIET_TAG_COUNT; i++) {
+        esp_log_level_set(quiet_tags[i], saved_levels[i]);
+    }
+}
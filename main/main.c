@@ -10,6 +10,7 @@
 #include "freertos/queue.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "esp_adc/adc_oneshot.h"  // Updated to use the new ADC API
 #include "driver/uart.h"
@@ -17,6 +18,8 @@
 #include "led_control.h"
 #include "adc_reader.h"
 #include "light_meter.h"
+#include "frame_pool.h"
+#include "frame_record.h"
 #include "uart_handler.h"
 
 static const char *TAG = "LIGHT_METER";
@@ -25,7 +28,8 @@ static const char *TAG = "LIGHT_METER";
 volatile bool start_measurement = false;
 int current_iso = 100; // Default ISO value
 metering_mode_t current_metering_mode = METERING_CENTER_WEIGHTED; // Default metering mode
-led_measurement_t led_measurements[5][4]; // Detailed measurements for all 20 LEDs
+light_frame_t *latest_frame = NULL; // Pool reference to the most recent frame
+uint32_t measurement_seq = 0; // Sequence number of the latest measurement
 
 // Function prototypes
 void app_main(void);
@@ -34,6 +38,7 @@ void update_metering_mode(metering_mode_t mode);
 void update_k_value(float k_value);
 void trigger_measurement(void);
 void print_detailed_measurements(void);
+void print_frame_record(float ev, int64_t time_us);
 
 void app_main(void)
 {
@@ -47,6 +52,9 @@ void app_main(void)
     // Initialize ADC reader
     adc_reader_init();
     
+    // Initialize the shared frame pool
+    frame_pool_init();
+    
     // Set initial K value for reflected light
     set_k_value(2.5f); // Standard K value for reflected light (range 0-100)
     
@@ -56,37 +64,73 @@ void app_main(void)
     
     ESP_LOGI(TAG, "Initialization Complete. Ready for measurements.");
 
+    // Time the next streamed frame is due
+    int64_t next_stream_us = 0;
+
     // Main loop
     while (1) {
         // Check for UART commands
         check_uart_commands();
         
+        // While streaming, a frame is due every stream interval
+        uint32_t stream_interval_ms = frame_record_stream_interval();
+        bool stream_due = false;
+        if (stream_interval_ms > 0 && esp_timer_get_time() >= next_stream_us) {
+            next_stream_us = esp_timer_get_time() + stream_interval_ms * 1000LL;
+            stream_due = true;
+        }
+        
         // If measurement is triggered
-        if (start_measurement) {
+        if (start_measurement || stream_due) {
             ESP_LOGI(TAG, "Starting light measurement with %s metering...", 
                     get_metering_mode_name(current_metering_mode));
             
-            // Measure all LEDs with detailed values
-            measure_all_leds_detailed(led_measurements);
-            
-            // Calculate exposure values using the current metering mode
-            float ev = calculate_ev_from_detailed(led_measurements, current_metering_mode);
-            float shutter_speed = calculate_shutter_speed(ev, current_iso);
-            
-            // Display results
-            ESP_LOGI(TAG, "Light measurement completed. EV: %.2f, ISO: %d, Recommended Shutter Speed: %.4f", 
-                          ev, current_iso, shutter_speed);
+            // Take a free frame from the pool; skip this trigger if consumers still hold them all
+            light_frame_t *frame = frame_pool_acquire();
+            if (frame == NULL) {
+                ESP_LOGE(TAG, "No free frame for measurement");
+                if (start_measurement) {
+                    printf("Error: Measurement skipped (frame pool exhausted)\n> ");
+                }
+            } else {
+                // Measure all LEDs into the compact frame
+                int64_t measure_time_us = esp_timer_get_time();
+                measure_frame(frame);
+                measurement_seq++;
+                
+                // Publish it as the latest frame, dropping our reference to the previous one
+                frame_pool_release(latest_frame);
+                latest_frame = frame;
+                
+                // Calculate exposure values using the current metering mode
+                float ev = calculate_ev_from_frame(frame, current_metering_mode);
+                float shutter_speed = calculate_shutter_speed(ev, current_iso);
+                
+                // Display results
+                ESP_LOGI(TAG, "Light measurement completed. EV: %.2f, ISO: %d, Recommended Shutter Speed: %.4f", 
+                              ev, current_iso, shutter_speed);
 
-            // Print detailed measurements
-            print_detailed_measurements();
-            
-            // Print exposure recommendation (TTL meter - no aperture)
-            char buffer[100];
-            get_exposure_recommendation(ev, current_iso, buffer, sizeof(buffer));
-            printf("\nExposure recommendation: %s\n", buffer);
-            printf("Metering mode: %s\n", get_metering_mode_name(current_metering_mode));
-            printf("K value: %.1f (reflected light)\n\n", get_k_value());
-            printf("> ");  // Reprint prompt
+                if (!start_measurement) {
+                    // A streamed frame is reported by its REC line alone
+                    print_frame_record(ev, measure_time_us);
+                } else {
+                    // Print detailed measurements
+                    print_detailed_measurements();
+                    
+                    // Record the raw frame for replay when enabled
+                    if (frame_record_enabled()) {
+                        print_frame_record(ev, measure_time_us);
+                    }
+                    
+                    // Print exposure recommendation (TTL meter - no aperture)
+                    char buffer[100];
+                    get_exposure_recommendation(ev, current_iso, buffer, sizeof(buffer));
+                    printf("\nExposure recommendation: %s\n", buffer);
+                    printf("Metering mode: %s\n", get_metering_mode_name(current_metering_mode));
+                    printf("K value: %.1f (reflected light)\n\n", get_k_value());
+                    printf("> ");  // Reprint prompt
+                }
+            }
             
             // Reset flag
             start_measurement = false;
@@ -122,6 +166,18 @@ void trigger_measurement(void) {
 
 // Print detailed measurements including ADC, voltage, and lux values
 void print_detailed_measurements(void) {
+    if (latest_frame == NULL) {
+        return;
+    }
+    
+    led_measurement_t measurements[5][4];
+    light_frame_t *frame = frame_pool_ref(latest_frame);
+    if (frame == NULL) {
+        return;
+    }
+    light_frame_to_measurements(frame, measurements);
+    frame_pool_release(frame);
+    
     printf("\n================= DETAILED MEASUREMENTS =================\n");
     printf("    | Column 1      | Column 2      | Column 3      | Column 4      |\n");
     printf("Row | ADC  V    Lux | ADC  V    Lux | ADC  V    Lux | ADC  V    Lux |\n");
@@ -132,13 +188,38 @@ void print_detailed_measurements(void) {
         
         for (int col = 0; col < 4; col++) {
             printf(" %4d %.2fV %5.1f |", 
-                led_measurements[row][col].adc_value, 
-                led_measurements[row][col].voltage, 
-                led_measurements[row][col].lux);
+                measurements[row][col].adc_value, 
+                measurements[row][col].voltage, 
+                measurements[row][col].lux);
         }
         
         printf("\n");
     }
     
     printf("===========================================================\n");
+}
+
+// Print the latest frame with its configuration and result as a REC line
+void print_frame_record(float ev, int64_t time_us) {
+    if (latest_frame == NULL) {
+        return;
+    }
+    
+    light_frame_t *frame = frame_pool_ref(latest_frame);
+    if (frame == NULL) {
+        return;
+    }
+    
+    frame_record_t record = {
+        .seq = measurement_seq,
+        .time_us = time_us,
+        .iso = current_iso,
+        .mode = current_metering_mode,
+        .k_value = get_k_value(),
+        .ev = ev,
+    };
+    memcpy(record.raw, frame->raw, sizeof(record.raw));
+    frame_pool_release(frame);
+    
+    frame_record_write(stdout, &record);
 }
\ No newline at end of file
@@ -4,9 +4,15 @@
  */
 
 #include "uart_handler.h"
+#include "frame_pool.h"
+#include "frame_record.h"
+#include "adc_reader.h"
+#include "bench.h"
+#include "log_quiet.h"
 #include "esp_log.h"
 #include "esp_console.h"
 #include "esp_system.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -49,10 +55,35 @@ static char* trim(char* str) {
     return str;
 }
 
+/**
+ * Quiet the per-measurement logs while streaming, and restore them afterwards
+ * Holds one log_quiet reference however often streaming is restarted
+ */
+static void set_stream_logging(bool enabled) {
+    static bool quiet = false;
+
+    if (!enabled && !quiet) {
+        log_quiet_acquire();
+        quiet = true;
+    } else if (enabled && quiet) {
+        log_quiet_release();
+        quiet = false;
+    }
+}
+
 /**
  * Process a command string
  */
 static void process_command(char *cmd) {
+    // Clock sync pings arrive every second or so: answer at once, without a log
+    // line or prompt, so they can interleave with other commands. The host pairs
+    // the device time with its own send and receive times.
+    if (strncmp(cmd, "sync ", 5) == 0) {
+        printf("SYNC,%s,%lld\n", trim(cmd + 5), (long long)esp_timer_get_time());
+        fflush(stdout);
+        return;
+    }
+
     ESP_LOGI(TAG, "Processing command: '%s'", cmd);
     
     // Trim whitespace
@@ -101,6 +132,33 @@ static void process_command(char *cmd) {
             printf("Error: Invalid K value (must be between 0 and 100)\n");
         }
     }
+    else if (strncmp(cmd, "config scan ", 12) == 0) {
+        const scan_preset_t *preset = adc_reader_find_scan_preset(cmd + 12);
+        
+        if (preset != NULL) {
+            adc_reader_set_scan_config(&preset->config);
+            printf("Scan strategy set to: %s\n", preset->name);
+        } else {
+            int count;
+            const scan_preset_t *presets = adc_reader_scan_presets(&count);
+            
+            printf("Error: Unknown scan strategy. Available:");
+            for (int i = 0; i < count; i++) {
+                printf(" %s", presets[i].name);
+            }
+            printf("\n");
+        }
+    }
+    else if (strncmp(cmd, "config output ", 14) == 0) {
+        frame_format_t format;
+        
+        if (frame_record_format_from_name(cmd + 14, &format)) {
+            frame_record_set_format(format);
+            printf("Record output format set to: %s\n", frame_record_format_name(format));
+        } else {
+            printf("Error: Unknown output format. Available: text jsonl binary\n");
+        }
+    }
     else if (strcmp(cmd, "start measure") == 0) {
         ESP_LOGI(TAG, "Start measure command received");
         
@@ -111,12 +169,74 @@ static void process_command(char *cmd) {
             printf("Error: Measurement callback not registered\n");
         }
     }
+    else if (strcmp(cmd, "record on") == 0) {
+        // Calibration first, so the recording replays with this chip's voltages
+        adc_reader_print_calibration(stdout);
+        frame_record_set_enabled(true);
+        printf("Frame recording enabled\n");
+    }
+    else if (strcmp(cmd, "record off") == 0) {
+        frame_record_set_enabled(false);
+        printf("Frame recording disabled\n");
+    }
+    else if (strncmp(cmd, "stream ", 7) == 0) {
+        const char *arg = cmd + 7;
+        int interval_ms = (strncmp(arg, "on", 2) == 0) ? atoi(arg + 2) : -1;
+        
+        if (strcmp(arg, "off") == 0) {
+            frame_record_set_stream_interval(0);
+            set_stream_logging(true);
+            printf("Frame streaming disabled\n");
+        } else if (interval_ms >= 0) {
+            if (interval_ms == 0) {
+                interval_ms = FRAME_STREAM_INTERVAL_MS;
+            }
+            // Calibration first, as for record on, then keep per-frame logs out of the stream
+            adc_reader_print_calibration(stdout);
+            set_stream_logging(false);
+            frame_record_set_stream_interval((uint32_t)interval_ms);
+            printf("Frame streaming every %d ms\n", interval_ms);
+        } else {
+            printf("Error: Usage: stream <on [ms]|off>\n");
+        }
+    }
+    else if (strcmp(cmd, "pool stats") == 0) {
+        frame_pool_stats_t stats;
+        frame_pool_get_stats(&stats);
+        printf("Frame pool: %d frames, %lu in use (peak %lu), %lu acquired, %lu exhausted\n",
+               FRAME_POOL_SIZE, (unsigned long)stats.in_use, (unsigned long)stats.peak_in_use,
+               (unsigned long)stats.acquired, (unsigned long)stats.exhausted);
+    }
+    else if (strncmp(cmd, "bench ", 6) == 0) {
+        char target[16];
+        int iterations = 0;
+        bool ok = false;
+        
+        if (sscanf(cmd + 6, "%15s %d", target, &iterations) == 2) {
+            if (strcmp(target, "kernel") == 0) {
+                ok = bench_kernels(stdout, iterations);
+            } else if (strcmp(target, "scan") == 0) {
+                ok = bench_scan(stdout, iterations);
+            }
+        }
+        
+        if (!ok) {
+            printf("Error: Usage: bench <kernel|scan> <iterations>\n");
+        }
+    }
     else if (strcmp(cmd, "help") == 0) {
         printf("\nAvailable commands:\n");
         printf("  config iso <value>         - Set ISO value (e.g., 100, 400, 800)\n");
         printf("  config type <mode>         - Set metering type (center, matrix, spot, highlight)\n");
         printf("  config k_value <value>     - Set K value for reflected light (standard: 2.5, range: 0-100)\n");
+        printf("  config scan <strategy>     - Set scan strategy (default, serial-fast, column, ...)\n");
+        printf("  config output <format>     - Set REC record format (text, jsonl, binary)\n");
         printf("  start measure              - Start light measurement\n");
+        printf("  record <on|off>            - Print a replayable REC line for each measurement\n");
+        printf("  stream <on [ms]|off>       - Measure continuously, one REC line per frame (default 33 ms)\n");
+        printf("  pool stats                 - Show frame pool usage and exhaustion counters\n");
+        printf("  sync <token>               - Reply SYNC,<token>,<device time in us> for clock sync\n");
+        printf("  bench <kernel|scan> <n>    - Time metering kernels or n scans per strategy\n");
         printf("  help                       - Show this help\n");
         printf("  reset                      - Reset the device\n\n");
     }
@@ -160,20 +280,10 @@ void uart_handler_init(void (*iso_callback)(int), void (*measure_callback)(void)
 }
 
 /**
- * Check for UART commands and process them
+ * Handle one console character: echo it, edit the line and run complete commands
+ * Returns true when the character completed a command line
  */
-void check_uart_commands(void) {
-    // Read one character at a time from stdin
-    char c;
-    int res = fgetc(stdin);
-    
-    // If no character is available, return
-    if (res == EOF) {
-        return;
-    }
-    
-    c = (char)res;
-    
+static bool handle_char(char c) {
     // Echo character back to console (if not newline or carriage return)
     if (c != '\n' && c != '\r') {
         fputc(c, stdout);
@@ -189,6 +299,7 @@ void check_uart_commands(void) {
         // Reset command buffer
         memset(cmd_line, 0, UART_BUF_SIZE);
         cmd_len = 0;
+        return true;
     } 
     else if (c == 0x08 || c == 0x7F) {  // Backspace or Delete
         // Remove last character if buffer not empty
@@ -205,4 +316,26 @@ void check_uart_commands(void) {
             cmd_line[cmd_len++] = c;
         }
     }
+    
+    return false;
+}
+
+/**
+ * Check for UART commands and process them
+ * Drains the characters already received, so a command is answered on the
+ * first poll after it arrives rather than one character per poll, but runs at
+ * most one command per poll: the main loop acts on it (e.g. measures after
+ * 'start measure') before the next queued command can change the config
+ */
+void check_uart_commands(void) {
+    int res;
+    
+    while ((res = fgetc(stdin)) != EOF) {
+        if (handle_char((char)res)) {
+            return;
+        }
+    }
+    
+    // Clear the EOF/error indicator so the next poll reads again
+    clearerr(stdin);
 }
\ No newline at end of file